@@ -0,0 +1,111 @@
+#include <stdlib.h>
+#include <string.h>
+#include "arena.h"
+
+
+/*----- CONSTANTS -----*/
+/** \brief Alignment of the memory given by an arena, enough for any type. The AVX loads of the force kernel never cross a cache line*/
+#define gARENA_ALIGNMENT 32
+
+
+/*----- STRUCTURES -----*/
+/** \brief Header of a block of an arena. The data starts at the first address aligned on gARENA_ALIGNMENT after the header
+ * \param next : block allocated before this one
+ * \param size : number of bytes of data
+ * \param used : number of bytes of data given*/
+struct ArenaBlock
+{
+	ArenaBlock* next;
+	size_t size;
+	size_t used;
+};
+
+
+/*----- INTERNAL FUNCTIONS -----*/
+/** \brief Round a size up to the alignment of the arena
+ * \param size : number of bytes
+ * \return size rounded up*/
+static size_t alignSize(const size_t size)
+{
+	return (size + gARENA_ALIGNMENT - 1) & ~(size_t)(gARENA_ALIGNMENT - 1);
+}
+
+/** \brief Get the first byte of data of a block, aligned on gARENA_ALIGNMENT
+ * \param b : block
+ * \return pointer to the data*/
+static unsigned char* blockData(ArenaBlock* b)
+{
+	const uintptr_t data = (uintptr_t)(b + 1);
+	return (unsigned char*)((data + gARENA_ALIGNMENT - 1) & ~(uintptr_t)(gARENA_ALIGNMENT - 1));
+}
+
+
+/*----- ARENA FUNCTIONS -----*/
+void arenaInit(Arena* a)
+{
+	memset(a, 0, sizeof(Arena));
+}
+
+void* arenaAlloc(Arena* a, const size_t size)
+{
+	const size_t aligned = alignSize(size ? size : 1);
+	ArenaBlock* b = a->blocks;
+
+	/*Start a new block, twice as large as the current one, when the current one is full*/
+	if (!b || b->size - b->used < aligned)
+	{
+		size_t blockSize = b ? b->size * 2 : gARENA_FIRST_BLOCK_SIZE;
+		while (blockSize < aligned) blockSize *= 2;
+
+		/*Room for the header and for its alignment padding*/
+		b = (ArenaBlock*)malloc(sizeof(ArenaBlock) + gARENA_ALIGNMENT + blockSize);
+		if (!b) return NULL;
+
+		b->next = a->blocks;
+		b->size = blockSize;
+		b->used = 0;
+		a->blocks = b;
+		a->reserved += blockSize;
+	}
+
+	void* memory = blockData(b) + b->used;
+	b->used += aligned;
+	a->used += aligned;
+	if (a->used > a->highWater) a->highWater = a->used;
+
+	return memory;
+}
+
+void* arenaGrow(Arena* a, void* array, const size_t oldSize, const size_t newSize)
+{
+	if (!a) return realloc(array, newSize);
+
+	void* memory = arenaAlloc(a, newSize);
+	if (memory && array) memcpy(memory, array, oldSize < newSize ? oldSize : newSize);
+	return memory;
+}
+
+void arenaRelease(Arena* a, void* array)
+{
+	if (!a) free(array);
+}
+
+void arenaReset(Arena* a)
+{
+	const size_t highWater = a->highWater;
+
+	while (a->blocks)
+	{
+		ArenaBlock* next = a->blocks->next;
+		free(a->blocks);
+		a->blocks = next;
+	}
+
+	arenaInit(a);
+	a->highWater = highWater;
+}
+
+size_t arenaHighWater(const Arena* a)
+{
+	return a->highWater;
+}
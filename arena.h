@@ -0,0 +1,67 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+
+/*----- CONSTANTS -----*/
+/** \brief Size of the first block of an arena, in bytes. Each next block is twice as large*/
+#define gARENA_FIRST_BLOCK_SIZE (64 * 1024)
+
+
+/*----- STRUCTURES -----*/
+/** \brief Block of memory of an arena, followed by its data*/
+typedef struct ArenaBlock ArenaBlock;
+
+
+/** \brief Structure of an arena : memory given by moving a pointer forward in large blocks, all freed at once by arenaReset().
+ * Nothing is freed separately : growing an array copies it to a new place, and its old place is only freed by the reset
+ * \param blocks : blocks allocated since the last reset, the current one first
+ * \param used : number of bytes given since the last reset
+ * \param reserved : number of bytes allocated in the blocks
+ * \param highWater : greatest number of bytes given between two resets*/
+typedef struct Arena
+{
+	ArenaBlock* blocks;
+	size_t used;
+	size_t reserved;
+	size_t highWater;
+} Arena;
+
+
+/*----- FUNCTION PROTOTYPES -----*/
+/** \brief Initialize an empty arena. No block is allocated before the first allocation
+ * \param a : arena to initialize*/
+void arenaInit(Arena* a);
+
+/** \brief Allocate memory in an arena, aligned for any type. The memory is not initialized
+ * \param a : arena
+ * \param size : number of bytes
+ * \return pointer to the memory. NULL if the allocation failed*/
+void* arenaAlloc(Arena* a, const size_t size);
+
+/** \brief Move an array to a larger place, like realloc(). Without an arena, it is realloc()
+ * \param a : arena of the array. NULL for an array allocated with malloc()
+ * \param array : array to grow. NULL to allocate a new one
+ * \param oldSize : size of the array, in bytes
+ * \param newSize : new size of the array, in bytes
+ * \return pointer to the array. NULL if the allocation failed : the array is left unchanged*/
+void* arenaGrow(Arena* a, void* array, const size_t oldSize, const size_t newSize);
+
+/** \brief Free an array allocated by arenaGrow(). Within an arena, it does nothing : the array is freed by the reset
+ * \param a : arena of the array. NULL for an array allocated with malloc()
+ * \param array : array to free*/
+void arenaRelease(Arena* a, void* array);
+
+/** \brief Free all the memory of an arena at once. The arena can be used again afterwards
+ * \param a : arena to reset*/
+void arenaReset(Arena* a);
+
+/** \brief Get the high-water mark of an arena
+ * \param a : arena
+ * \return greatest number of bytes given between two resets, including the current one*/
+size_t arenaHighWater(const Arena* a);
+
+#endif
@@ -0,0 +1,347 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "chargecore.h"
+#include "draworder.h"
+#include "threadpool.h"
+#include "timer.h"
+
+
+/*----- CONSTANTS -----*/
+/** \brief Numbers of particles of the levels benchmarked*/
+const int32_t gBENCH_SIZES[] = {10, 100, 1000, 10000, 100000};
+#define gNUMBER_OF_BENCH_SIZES 5
+
+/** \brief Size of the playable area and radius of the particles, as in the game*/
+#define gBENCH_WIDTH 640
+#define gBENCH_HEIGHT 480
+#define gBENCH_PARTICLE_RADIUS 10
+
+/** \brief One particle out of gBENCH_MOVING_RATIO is a moving particle*/
+#define gBENCH_MOVING_RATIO 10
+
+/** \brief Number of positions tested by an iteration of the hit test benchmark*/
+#define gBENCH_HIT_TESTS 1000
+
+/** \brief A benchmark is run until it lasted gBENCH_MIN_TIME and gBENCH_MIN_ITERATIONS iterations, and stops after gBENCH_MAX_TIME
+ * or gBENCH_MAX_ITERATIONS iterations. It always runs at least once. Times in nanoseconds*/
+#define gBENCH_MIN_TIME 200000000u
+#define gBENCH_MAX_TIME 2000000000u
+#define gBENCH_MIN_ITERATIONS 3
+#define gBENCH_MAX_ITERATIONS 1000
+
+/** \brief Minimum number of threads of the parallel step benchmarks. One per logical core above*/
+#define gBENCH_MIN_THREADS 2
+
+/** \brief Name of the level files written and read by the level I/O benchmarks, removed at the end*/
+#define gBENCH_TEXT_FILE "chargegame_bench" gLEVEL_TEXT_EXTENSION
+#define gBENCH_BINARY_FILE "chargegame_bench" gLEVEL_BINARY_EXTENSION
+
+
+/*----- TYPES -----*/
+/** \brief Iteration of a benchmark
+ * \param l : level benchmarked*/
+typedef void (*BenchFunction)(Level* l);
+
+
+/*----- VARIABLES -----*/
+/** \brief State of the pseudo-random generator : the levels and the positions tested are the same for every run*/
+uint32_t gRandom = 1;
+
+/** \brief Drawing order of the particles, updated as updateDrawOrder() of the game updates it*/
+DrawOrder gDrawOrder;
+
+/** \brief Drawing order of the particles before the last physics step. Sorted again by the draw_order_resort benchmark*/
+int32_t* gPreviousDrawOrder = NULL;
+
+/** \brief Level read by the level load benchmarks*/
+Level gLoadedLevel;
+
+/** \brief High scores written in the level files*/
+const int32_t gBENCH_HIGH_SCORES[3] = {-1, -1, -1};
+
+/** \brief Durations of the iterations of the running benchmark, in nanoseconds. Sorted to get its percentiles*/
+uint64_t gSamples[gBENCH_MAX_ITERATIONS];
+
+/** \brief True before the first result is printed : separates the results of the JSON array*/
+bool gFirstResult = true;
+
+
+/*----- INTERNAL FUNCTIONS -----*/
+/** \brief Get a pseudo-random number (xorshift)
+ * \param n : number of values
+ * \return number in [0, n)*/
+static int32_t randomInt(const int32_t n)
+{
+	gRandom ^= gRandom << 13;
+	gRandom ^= gRandom >> 17;
+	gRandom ^= gRandom << 5;
+	return (int32_t)(gRandom % (uint32_t)n);
+}
+
+/** \brief Fill a level with a goal, a row of walls and particles spread out of them
+ * \param l : level, initialized and empty
+ * \param n : number of particles*/
+static void buildLevel(Level* l, const int32_t n)
+{
+	int32_t i;
+	const int margin = gBENCH_PARTICLE_RADIUS + 2;
+
+	gRandom = 1;
+	levelSetGoal(l, gBENCH_WIDTH - 60, gBENCH_HEIGHT - 60, 40, 40);
+
+	/*Walls in the band y in [200, 280), particles above and below it : no particle is created in a wall*/
+	for (i = 0; i < 8; ++i) levelCreateWall(l, 20 + i * 80, 200, 40, 80);
+
+	for (i = 0; i < n; ++i)
+	{
+		const bool moving = i % gBENCH_MOVING_RATIO == 0;
+		const int x = margin + randomInt(gBENCH_WIDTH - 100 - 2 * margin);
+		int y = randomInt(gBENCH_HEIGHT - 80 - 4 * margin);
+		y = y < 200 - 2 * margin ? margin + y : 280 + margin + y - (200 - 2 * margin);
+
+		levelCreateParticle(l, moving, false, moving ? 1 : randomInt(7) - 3, x, y);
+	}
+}
+
+
+/** \brief Comparison function of qsort() for the durations of gSamples
+ * \param a : pointer to the first duration
+ * \param b : pointer to the second duration
+ * \return negative, 0 or positive if the first duration is shorter, equal or longer*/
+static int compareSamples(const void* a, const void* b)
+{
+	const uint64_t t1 = *(const uint64_t*)a, t2 = *(const uint64_t*)b;
+
+	return (t1 > t2) - (t1 < t2);
+}
+
+/** \brief Get a percentile of the sorted durations of gSamples, by the nearest rank
+ * \param count : number of durations in gSamples, at least 1
+ * \param percentile : percentile to get, between 0 and 100
+ * \return duration in nanoseconds*/
+static uint64_t samplePercentile(const int32_t count, const double percentile)
+{
+	int32_t rank = (int32_t)(percentile / 100 * count + 0.999999);
+
+	if (rank < 1) rank = 1;
+	if (rank > count) rank = count;
+	return gSamples[rank - 1];
+}
+
+
+/*----- BENCHMARKS -----*/
+/** \brief One physics step of the level, with its force solver*/
+static void benchStep(Level* l)
+{
+	levelStep(l, gPHYSICS_TIMESTEP);
+}
+
+/** \brief Acceleration of every moving particle, with the force solver of the level*/
+static void benchAcceleration(Level* l)
+{
+	int32_t p;
+	double ax, ay;
+
+	for (p = 0; p < l->numberOfParticle; ++p)
+	{
+		if (l->particles.flags[p] & EParticleFlag_MOVING) getAcceleration(l, p, &ax, &ay);
+	}
+}
+
+/** \brief Collisions of every particle with the walls, the goal and the limits of the playable area*/
+static void benchCollisions(Level* l)
+{
+	int32_t p;
+
+	for (p = 0; p < l->numberOfParticle; ++p) collisions(l, p);
+}
+
+/** \brief Drawing order built from scratch, as when particles are created or destroyed*/
+static void benchDrawOrderSort(Level* l)
+{
+	gDrawOrder.numberOfParticles = 0;
+	drawOrderUpdate(&gDrawOrder, l);
+}
+
+/** \brief Drawing order of the frame before a physics step, sorted again after it*/
+static void benchDrawOrderResort(Level* l)
+{
+	memcpy(gDrawOrder.order, gPreviousDrawOrder, l->numberOfParticle * sizeof(int32_t));
+	drawOrderUpdate(&gDrawOrder, l);
+}
+
+/** \brief gBENCH_HIT_TESTS positions of the playable area tested for the particle drawn on top of them, as handOnParticle() of the game*/
+static void benchHitTest(Level* l)
+{
+	int32_t i;
+
+	for (i = 0; i < gBENCH_HIT_TESTS; ++i) drawOrderParticleAt(&gDrawOrder, l, randomInt(gBENCH_WIDTH), randomInt(gBENCH_HEIGHT));
+}
+
+/** \brief Level written in the text format*/
+static void benchSaveText(Level* l)
+{
+	levelSave(l, gBENCH_TEXT_FILE, true, gBENCH_HIGH_SCORES, ELevelFormat_TEXT);
+}
+
+/** \brief Level written in the binary format*/
+static void benchSaveBinary(Level* l)
+{
+	levelSave(l, gBENCH_BINARY_FILE, true, gBENCH_HIGH_SCORES, ELevelFormat_BINARY);
+}
+
+/** \brief Level written by benchSaveText() read in gLoadedLevel*/
+static void benchLoadText(Level* l)
+{
+	(void)l;
+	levelLoad(&gLoadedLevel, gBENCH_TEXT_FILE, false, NULL);
+}
+
+/** \brief Level written by benchSaveBinary() read in gLoadedLevel*/
+static void benchLoadBinary(Level* l)
+{
+	(void)l;
+	levelLoad(&gLoadedLevel, gBENCH_BINARY_FILE, false, NULL);
+}
+
+/** \brief Run a benchmark and print its result as an element of the JSON array of the results
+ * \param name : name of the benchmark
+ * \param l : level benchmarked
+ * \param items : number of items processed by an iteration : particles, positions tested...
+ * \param function : iteration of the benchmark
+ * \param extraFields : other fields of the result, in JSON, printed after the timings. Can be NULL*/
+static void runBenchmark(const char* name, Level* l, const int32_t items, BenchFunction function, const char* extraFields)
+{
+	int32_t count = 0;
+	uint64_t total = 0;
+
+	fprintf(stderr, "%-22s %6d particles ... ", name, l->numberOfParticle);
+
+	while (count < gBENCH_MAX_ITERATIONS && total < gBENCH_MAX_TIME && (total < gBENCH_MIN_TIME || count < gBENCH_MIN_ITERATIONS))
+	{
+		const uint64_t start = timerNanoseconds();
+		function(l);
+		const uint64_t time = timerNanoseconds() - start;
+
+		gSamples[count++] = time;
+		total += time;
+	}
+
+	/*The percentiles are read from the exact durations : a histogram would round the sub-microsecond benchmarks*/
+	qsort(gSamples, count, sizeof(uint64_t), compareSamples);
+
+	const double mean = (double)total / count;
+	fprintf(stderr, "%12.3f us \n", mean * 1e-3);
+
+	printf("%s\n    {\"name\": \"%s\", \"particles\": %d, \"threads\": %d, \"items\": %d, \"iterations\": %d, \"mean_ns\": %.1f, \"p50_ns\": %llu, "
+	       "\"p95_ns\": %llu, \"min_ns\": %llu, \"max_ns\": %llu, \"ns_per_item\": %.3f%s%s}", gFirstResult ? "" : ",", name,
+	       l->numberOfParticle, l->numberOfThreads, items, count, mean, (unsigned long long)samplePercentile(count, 50),
+	       (unsigned long long)samplePercentile(count, 95), (unsigned long long)gSamples[0], (unsigned long long)gSamples[count - 1],
+	       mean / (items > 0 ? items : 1), extraFields ? ", " : "", extraFields ? extraFields : "");
+	gFirstResult = false;
+}
+
+/** \brief Run all the benchmarks on a level
+ * \param n : number of particles of the level*/
+static void benchmarkLevel(const int32_t n)
+{
+	Level l;
+	const char* stepNames[2][3] = {{"step_direct", "step_barnes_hut", "step_static_field"},
+	                               {"step_direct_parallel", "step_barnes_hut_parallel", "step_static_field_parallel"}};
+	const EForceSolver solvers[3] = {EForceSolver_DIRECT, EForceSolver_BARNES_HUT, EForceSolver_STATIC_FIELD};
+	const int32_t cores = threadPoolNumberOfCores();
+	const int32_t threads[2] = {1, cores > gBENCH_MIN_THREADS ? cores : gBENCH_MIN_THREADS};
+	int32_t i, t;
+
+	levelInit(&l, gBENCH_WIDTH, gBENCH_HEIGHT, gBENCH_PARTICLE_RADIUS);
+	buildLevel(&l, n);
+
+	drawOrderInit(&gDrawOrder);
+	gPreviousDrawOrder = (int32_t*)malloc(n * sizeof(int32_t));
+	if (!drawOrderUpdate(&gDrawOrder, &l) || !gPreviousDrawOrder)
+	{
+		printf("ERROR: Can't allocate the drawing order of %d particles \n", n);
+		exit(EXIT_FAILURE);
+	}
+
+	/*Physics : each force solver, from the initial positions, on one thread then on the thread pool*/
+	for (t = 0; t < 2; ++t)
+	{
+		levelSetNumberOfThreads(&l, threads[t]);
+
+		for (i = 0; i < 3; ++i)
+		{
+			char errorFields[100] = "";
+
+			levelSetForceSolver(&l, solvers[i]);
+			levelStart(&l);
+
+			/*Error bound of the approximation of Barnes-Hut, against the direct sum*/
+			if (solvers[i] == EForceSolver_BARNES_HUT && t == 0)
+			{
+				double rmsError, maxError;
+
+				levelForceError(&l, &rmsError, &maxError);
+				snprintf(errorFields, sizeof(errorFields), "\"rms_error\": %.3e, \"max_error\": %.3e", rmsError, maxError);
+			}
+			runBenchmark(stepNames[t][i], &l, l.numberOfMovingParticle, benchStep, errorFields[0] ? errorFields : NULL);
+
+			if (solvers[i] == EForceSolver_STATIC_FIELD && t == 0)
+			{
+				levelUpdateForceSolver(&l);
+				runBenchmark("acceleration", &l, l.numberOfMovingParticle, benchAcceleration, NULL);
+			}
+			levelReset(&l);
+		}
+	}
+	levelSetNumberOfThreads(&l, 1);
+	runBenchmark("collisions", &l, l.numberOfParticle, benchCollisions, NULL);
+
+	/*Drawing order : from scratch, then after a physics step moved the moving particles*/
+	runBenchmark("draw_order_sort", &l, l.numberOfParticle, benchDrawOrderSort, NULL);
+	memcpy(gPreviousDrawOrder, gDrawOrder.order, n * sizeof(int32_t));
+	levelStart(&l);
+	levelStep(&l, gPHYSICS_TIMESTEP);
+	runBenchmark("draw_order_resort", &l, l.numberOfParticle, benchDrawOrderResort, NULL);
+	levelReset(&l);
+
+	/*Hit test : the drawing order is up to date, as after the update of a frame*/
+	drawOrderUpdate(&gDrawOrder, &l);
+	runBenchmark("hit_test", &l, gBENCH_HIT_TESTS, benchHitTest, NULL);
+
+	/*Level I/O*/
+	levelInit(&gLoadedLevel, gBENCH_WIDTH, gBENCH_HEIGHT, gBENCH_PARTICLE_RADIUS);
+	runBenchmark("level_save_text", &l, l.numberOfParticle, benchSaveText, NULL);
+	runBenchmark("level_save_binary", &l, l.numberOfParticle, benchSaveBinary, NULL);
+	runBenchmark("level_load_text", &l, l.numberOfParticle, benchLoadText, NULL);
+	runBenchmark("level_load_binary", &l, l.numberOfParticle, benchLoadBinary, NULL);
+	levelFree(&gLoadedLevel);
+	remove(gBENCH_TEXT_FILE);
+	remove(gBENCH_BINARY_FILE);
+
+	drawOrderFree(&gDrawOrder);
+	free(gPreviousDrawOrder);
+	levelFree(&l);
+}
+
+
+/*----- MAIN -----*/
+/** \brief Benchmark the core of the game on levels of 10 to 100000 particles : physics steps with each force solver on one thread and on the thread pool, accelerations,
+ * collisions, drawing order of the particles, hit tests and level files. The results are printed on the standard output in JSON,
+ * to be compared between builds. The progress is printed on the error output.
+ * Usage : chargegame_bench [maxParticles]*/
+int main(int argc, char* argv[])
+{
+	const int32_t maxParticles = argc > 1 ? atoi(argv[1]) : gMAX_PARTICLES;
+	const char* kernels[3] = {"scalar", "sse2", "avx2"};
+	int32_t i;
+
+	printf("{\n  \"benchmark\": \"chargegame_bench\",\n  \"real\": \"%s\",\n  \"kernel\": \"%s\",\n  \"results\": [",
+	       sizeof(Real) == sizeof(float) ? "float" : "double", kernels[forceKernelInstructionSet()]);
+
+	for (i = 0; i < gNUMBER_OF_BENCH_SIZES && gBENCH_SIZES[i] <= maxParticles; ++i) benchmarkLevel(gBENCH_SIZES[i]);
+
+	printf("\n  ]\n}\n");
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,1184 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include <string.h>
+#include "chargecore.h"
+
+
+/*----- CONSTANTS -----*/
+const int32_t gMAX_PARTICULE_CHARGE = 3;
+const int32_t gMIN_PARTICULE_CHARGE = -3;
+const double gMAX_SPEED = 0.5;
+const double gMAX_ACCELERATION = 0.005;
+const int32_t gPARTICLE_MASS = 10;
+const double gMIN_DISTANCE = 5;
+const double gTIME_MULTIPLIER = 0.7;
+const double gPHYSICS_TIMESTEP = 16;
+const int32_t gMAX_STEPS_PER_FRAME = 4;
+const double gDEFAULT_OPENING_ANGLE = 0.5;
+const int64_t gDIRECT_SUM_MAX_INTERACTIONS = 1000000;
+
+
+/*----- INTERNAL FUNCTIONS -----*/
+/** \brief test if the position passed in parameter (x, y) is on a rectangle passed in parameter.
+* Same behaviour as surfaceHitbox() in chargegame.c, on plain integers instead of a SDL_Rect
+* \param rx, ry, rw, rh : rectangle to test
+* \param x : x coordinate of the position
+* \param y : y coordinate of the position
+* \param xNegShift : extend at the left of the rectangle
+* \param xPosShift : extend at the right of the rectangle
+* \param yNegShift : extend on top of the rectangle
+* \param yPosShift : extend on the bottom of the rectangle
+* \return : true if the position is within the rectangle*/
+static bool rectHitbox(const int rx, const int ry, const int rw, const int rh, const double x, const double y,
+                       const int xNegShift, const int xPosShift, const int yNegShift, const int yPosShift)
+{
+	return (int)x >= rx - xNegShift && (int)x <= rx + rw + xPosShift
+		&& (int)y >= ry - yNegShift && (int)y <= ry + rh + yPosShift;
+}
+
+/** \brief Ensure that the particle arrays of a level can store n particles. The arrays may be moved in memory, within the arena of the level
+* \param l : level
+* \param n : number of particles
+* \return false if an allocation failed*/
+static bool reserveParticles(Level* l, const int32_t n)
+{
+	ParticleArray* a = &l->particles;
+
+	if (n > l->particleCapacity)
+	{
+		Real* xCoord = (Real*)arenaGrow(&l->arena, a->xCoord, l->particleCapacity * sizeof(Real), n * sizeof(Real));
+		if (xCoord) a->xCoord = xCoord;
+		Real* yCoord = (Real*)arenaGrow(&l->arena, a->yCoord, l->particleCapacity * sizeof(Real), n * sizeof(Real));
+		if (yCoord) a->yCoord = yCoord;
+		Real* xSpeed = (Real*)arenaGrow(&l->arena, a->xSpeed, l->particleCapacity * sizeof(Real), n * sizeof(Real));
+		if (xSpeed) a->xSpeed = xSpeed;
+		Real* ySpeed = (Real*)arenaGrow(&l->arena, a->ySpeed, l->particleCapacity * sizeof(Real), n * sizeof(Real));
+		if (ySpeed) a->ySpeed = ySpeed;
+		Real* xCoordInit = (Real*)arenaGrow(&l->arena, a->xCoordInit, l->particleCapacity * sizeof(Real), n * sizeof(Real));
+		if (xCoordInit) a->xCoordInit = xCoordInit;
+		Real* yCoordInit = (Real*)arenaGrow(&l->arena, a->yCoordInit, l->particleCapacity * sizeof(Real), n * sizeof(Real));
+		if (yCoordInit) a->yCoordInit = yCoordInit;
+		int32_t* charge = (int32_t*)arenaGrow(&l->arena, a->charge, l->particleCapacity * sizeof(int32_t), n * sizeof(int32_t));
+		if (charge) a->charge = charge;
+		uint8_t* flags = (uint8_t*)arenaGrow(&l->arena, a->flags, l->particleCapacity * sizeof(uint8_t), n * sizeof(uint8_t));
+		if (flags) a->flags = flags;
+		Real* xPrevious = (Real*)arenaGrow(&l->arena, a->xPrevious, l->particleCapacity * sizeof(Real), n * sizeof(Real));
+		if (xPrevious) a->xPrevious = xPrevious;
+		Real* yPrevious = (Real*)arenaGrow(&l->arena, a->yPrevious, l->particleCapacity * sizeof(Real), n * sizeof(Real));
+		if (yPrevious) a->yPrevious = yPrevious;
+
+		if (!xCoord || !yCoord || !xSpeed || !ySpeed || !xCoordInit || !yCoordInit || !charge || !flags || !xPrevious || !yPrevious)
+			return false;
+		l->particleCapacity = n;
+	}
+	return true;
+}
+
+/** \brief Ensure that the wall array of a level can store n walls. The array may be moved in memory, within the arena of the level
+* \param l : level
+* \param n : number of walls
+* \return false if the allocation failed*/
+static bool reserveWalls(Level* l, const int32_t n)
+{
+	if (n > l->wallCapacity)
+	{
+		Wall* wallArray = (Wall*)arenaGrow(&l->arena, l->wallArray, l->wallCapacity * sizeof(Wall), n * sizeof(Wall));
+		if (!wallArray) return false;
+
+		l->wallArray = wallArray;
+		l->wallCapacity = n;
+	}
+	return true;
+}
+
+/** \brief Copy all the parameters of a particle over another one
+* \param l : level containing the particles
+* \param destination : index of the particle to overwrite
+* \param source : index of the particle to copy*/
+static void copyParticle(Level* l, const int32_t destination, const int32_t source)
+{
+	ParticleArray* a = &l->particles;
+
+	a->xCoord[destination] = a->xCoord[source];
+	a->yCoord[destination] = a->yCoord[source];
+	a->xSpeed[destination] = a->xSpeed[source];
+	a->ySpeed[destination] = a->ySpeed[source];
+	a->xCoordInit[destination] = a->xCoordInit[source];
+	a->yCoordInit[destination] = a->yCoordInit[source];
+	a->charge[destination] = a->charge[source];
+	a->flags[destination] = a->flags[source];
+	a->xPrevious[destination] = a->xPrevious[source];
+	a->yPrevious[destination] = a->yPrevious[source];
+}
+
+/** \brief Test if a particle is within the limits of the goal
+* \param l : level containing the particle
+* \param p : index of the particle to test
+* \return true if the particle is on the goal*/
+static bool isOnGoal(const Level* l, const int32_t p)
+{
+	const int r = l->particleRadius;
+
+	return rectHitbox(l->goal.x, l->goal.y, l->goal.w, l->goal.h, l->particles.xCoord[p], l->particles.yCoord[p], -r, -r, -r, -r);
+}
+
+/** \brief Stop a particle moving in a straight line on the first face of wall it crosses, so that fast particles can't tunnel through thin walls.
+* The faces are the ones of the hitbox of collisions() : the sides of a wall pushed away by the radius of the particles.
+* The speed across the face crossed is cancelled and the particle slides along it until the end of the move, which is swept again
+* \param l : level containing the particle
+* \param p : index of the particle
+* \param x0 : x coordinate of the particle at the beginning of the move
+* \param y0 : y coordinate of the particle at the beginning of the move
+* \param x : pointer to the x coordinate of the particle at the end of the move. Modified if a face is crossed
+* \param y : pointer to the y coordinate of the particle at the end of the move. Modified if a face is crossed*/
+static void sweepWalls(Level* l, const int32_t p, double x0, double y0, double* x, double* y)
+{
+	const int r = l->particleRadius;
+	int pass;
+
+	/*Each face crossed stops the move on one axis, so there are at most two faces crossed*/
+	for (pass = 0; pass < 2; ++pass)
+	{
+		const double dx = *x - x0, dy = *y - y0;
+		double tFace = 1, face = 0;
+		bool hit = false, xFace = false;
+		int32_t i = -1;
+
+		if (dx == 0 && dy == 0) return;
+
+		while ((i = wallGridNext(&l->wallGrid, (int)floor(dx < 0 ? *x : x0) - r, (int)floor(dy < 0 ? *y : y0) - r,
+		                         (int)ceil(dx < 0 ? x0 : *x) + r, (int)ceil(dy < 0 ? y0 : *y) + r, i)) != -1)
+		{
+			const Wall* w = &l->wallArray[i];
+			double t, c;
+
+			/*Left or right face, crossed at a time t between 0 and 1 of the move. The earliest face is kept*/
+			c = dx > 0 ? w->x - r : w->x + w->w + r;
+			if (dx != 0 && (dx > 0 ? x0 <= c : x0 >= c) && (t = (c - x0) / dx) <= tFace && (!hit || t < tFace)
+				&& y0 + dy * t >= w->y && y0 + dy * t <= w->y + w->h)
+			{
+				tFace = t;
+				face = c;
+				xFace = true;
+				hit = true;
+			}
+
+			/*Top or bottom face*/
+			c = dy > 0 ? w->y - r : w->y + w->h + r;
+			if (dy != 0 && (dy > 0 ? y0 <= c : y0 >= c) && (t = (c - y0) / dy) <= tFace && (!hit || t < tFace)
+				&& x0 + dx * t >= w->x && x0 + dx * t <= w->x + w->w)
+			{
+				tFace = t;
+				face = c;
+				xFace = false;
+				hit = true;
+			}
+		}
+
+		if (!hit) return;
+
+		/*Stop on the face and sweep the rest of the move along it*/
+		if (xFace)
+		{
+			y0 += dy * tFace;
+			x0 = face;
+			*x = face;
+			l->particles.xSpeed[p] = 0;
+		}
+		else
+		{
+			x0 += dx * tFace;
+			y0 = face;
+			*y = face;
+			l->particles.ySpeed[p] = 0;
+		}
+	}
+}
+
+/** \brief Move a moving particle during a time step, from its acceleration at the beginning of the step.
+* Test its collisions and set its EParticleFlag_GOAL flag if it reaches the goal. Only modify this particle
+* \param l : level containing the particle
+* \param p : index of the particle to move
+* \param t : duration of the step, multiplied by gTIME_MULTIPLIER*/
+static void stepParticle(Level* l, const int32_t p, const double t)
+{
+	ParticleArray* a = &l->particles;
+	const double xInit = a->xCoord[p];
+	const double yInit = a->yCoord[p];
+	double x = xInit;
+	double y = yInit;
+	const double xs = a->xSpeed[p];
+	const double ys = a->ySpeed[p];
+	double xa, ya, xSpeed, ySpeed;
+	getAcceleration(l, p, &xa, &ya);
+
+	/*Compute the new position*/
+	x += xs * t + 0.5 * xa * t * t;
+	y += ys * t + 0.5 * ya * t * t;
+
+	/*Get the new speed in function of the old and the new positions*/
+	if (t != 0)
+	{
+		xSpeed = (x - xInit) / t;
+		clamp(&xSpeed, gMAX_SPEED);
+		a->xSpeed[p] = (Real)xSpeed;
+
+		ySpeed = (y - yInit) / t;
+		clamp(&ySpeed, gMAX_SPEED);
+		a->ySpeed[p] = (Real)ySpeed;
+	}
+
+	/*Stop the particle on the walls it crossed during the step*/
+	sweepWalls(l, p, xInit, yInit, &x, &y);
+
+	/*Change the positions of the particle*/
+	a->xCoord[p] = (Real)x;
+	a->yCoord[p] = (Real)y;
+
+	/*Test for collisions of the particle*/
+	collisions(l, p);
+
+	/*test if the particle is on goal. The particles on goal are counted once all the particles have moved*/
+	if (isOnGoal(l, p)) a->flags[p] |= EParticleFlag_GOAL;
+}
+
+/** \brief Insert again all the walls of a level in its wall grid, after their indices changed
+* \param l : level*/
+static void rebuildWallGrid(Level* l)
+{
+	int32_t i;
+
+	wallGridClear(&l->wallGrid);
+	for (i = 0; i < l->numberOfWall; ++i)
+	{
+		const Wall* w = &l->wallArray[i];
+		wallGridInsert(&l->wallGrid, i, w->x, w->y, w->w, w->h);
+	}
+}
+
+/** \brief Mark the static field as not matching the non moving particles anymore. It is rasterized again by the next levelUpdateForceSolver()
+* \param l : level whose non moving particles changed*/
+static void invalidateStaticField(Level* l)
+{
+	l->staticFieldReady = false;
+	l->staticFieldFailed = false;
+}
+
+/** \brief Start the threads of a level if it has more than one and they are not started yet
+* \param l : level*/
+static void startThreads(Level* l)
+{
+	if (l->numberOfThreads > 1 && !l->threadPool)
+	{
+		l->threadPool = threadPoolCreate(l->numberOfThreads);
+		if (!l->threadPool)
+		{
+			printf("ERROR: Can't start %d threads, the particles are moved by one thread \n", l->numberOfThreads);
+			l->numberOfThreads = 1;
+		}
+	}
+}
+
+/** \brief Parameters of a parallel step, shared by all its tasks
+* \param l : level to step
+* \param t : duration of the step, multiplied by gTIME_MULTIPLIER*/
+typedef struct StepContext
+{
+	Level* l;
+	double t;
+} StepContext;
+
+/** \brief Task of the parallel step : move the moving particles [task * gSTEP_TASK_SIZE, (task + 1) * gSTEP_TASK_SIZE)
+* \param context : pointer to the StepContext of the step
+* \param task : index of the task*/
+static void stepTask(void* context, const int32_t task)
+{
+	const StepContext* step = (const StepContext*)context;
+	const uint8_t* flags = step->l->particles.flags;
+	const int32_t begin = task * gSTEP_TASK_SIZE;
+	const int32_t end = begin + gSTEP_TASK_SIZE < step->l->numberOfParticle ? begin + gSTEP_TASK_SIZE : step->l->numberOfParticle;
+	int32_t i;
+
+	for (i = begin; i < end; ++i)
+	{
+		if ((flags[i] & EParticleFlag_MOVING) && !(flags[i] & EParticleFlag_GOAL)) stepParticle(step->l, i, step->t);
+	}
+}
+
+/** \brief Sum the forces applied on a particle by all the other particles of the level, without approximation
+* \param l : level containing the particle
+* \param p : index of the particle to get the force
+* \param fx : pointer to output parameter x force
+* \param fy : pointer to output parameter y force*/
+static void getDirectForce(const Level* l, const int32_t p, double* fx, double* fy);
+
+/** \brief Sum the forces applied on a particle with the force solver of the level. Fall back to the direct sum if the solver is not ready
+* \param l : level containing the particle
+* \param p : index of the particle to get the force
+* \param fx : pointer to output parameter x force
+* \param fy : pointer to output parameter y force*/
+static void getSolverForce(const Level* l, const int32_t p, double* fx, double* fy);
+
+
+/*----- LEVEL LIFETIME -----*/
+void levelInit(Level* l, const int width, const int height, const int particleRadius)
+{
+	memset(l, 0, sizeof(Level));
+	l->width = width;
+	l->height = height;
+	l->particleRadius = particleRadius;
+	l->forceSolver = EForceSolver_DIRECT;
+	l->openingAngle = gDEFAULT_OPENING_ANGLE;
+	l->staticFieldCellSize = gFORCE_FIELD_CELL_SIZE;
+	l->numberOfThreads = 1;
+	arenaInit(&l->arena);
+	slotMapInit(&l->particleSlots, &l->arena);
+	slotMapInit(&l->wallSlots, &l->arena);
+	wallGridInit(&l->wallGrid, width, height, &l->arena);
+
+	/*Select the force kernel now, before several threads use it*/
+	forceKernelInstructionSet();
+}
+
+void levelFree(Level* l)
+{
+	/*Delete the particles and the walls : all their arrays are in the arena*/
+	memset(&l->particles, 0, sizeof(ParticleArray));
+	l->particleCapacity = 0;
+	l->numberOfParticle = 0;
+	l->numberOfMovingParticle = 0;
+	l->numberOfParticlesOnGoal = 0;
+	slotMapFree(&l->particleSlots);
+	l->wallArray = NULL;
+	l->wallCapacity = 0;
+	l->numberOfWall = 0;
+	slotMapFree(&l->wallSlots);
+	wallGridFree(&l->wallGrid);
+	arenaReset(&l->arena);
+
+	/*Delete the goal*/
+	levelDestroyGoal(l);
+
+	/*Free the buffers of the force solvers*/
+	quadtreeFree(&l->quadtree);
+	forceFieldFree(&l->staticField);
+	invalidateStaticField(l);
+	free(l->xMoving);
+	free(l->yMoving);
+	free(l->chargeMoving);
+	l->xMoving = NULL;
+	l->yMoving = NULL;
+	l->chargeMoving = NULL;
+	l->movingParticleCapacity = 0;
+
+	/*Stop the threads. They are started again by the next step*/
+	threadPoolDestroy(l->threadPool);
+	l->threadPool = NULL;
+
+	l->running = false;
+}
+
+
+/*----- CREATION FUNCTIONS -----*/
+int32_t levelCreateParticle(Level* l, bool moving, bool modifiable, const int32_t charge, const int x, const int y)
+{
+	const int32_t p = l->numberOfParticle;
+	ParticleArray* a = &l->particles;
+
+	if (l->numberOfParticle >= gMAX_PARTICLES)
+	{
+		printf("ERROR: Number max of particles reached \n");
+		return -1;
+	}
+
+	/*Grow the particle arrays if they are full*/
+	if (l->numberOfParticle == l->particleCapacity)
+	{
+		int32_t capacity = l->particleCapacity ? l->particleCapacity * 2 : 64;
+		if (capacity > gMAX_PARTICLES) capacity = gMAX_PARTICLES;
+
+		if (!reserveParticles(l, capacity)) return -1;
+	}
+
+	/*Handle of the particle, which follows it when its index changes*/
+	if (slotMapInsert(&l->particleSlots) == gNULL_HANDLE) return -1;
+
+	a->flags[p] = (uint8_t)((moving ? EParticleFlag_MOVING : 0) | (modifiable ? EParticleFlag_MODIFIABLE : 0));
+	a->charge[p] = charge;
+	a->xCoord[p] = (Real)x;
+	a->yCoord[p] = (Real)y;
+	a->xCoordInit[p] = a->xCoord[p];
+	a->yCoordInit[p] = a->yCoord[p];
+	a->xSpeed[p] = 0;
+	a->ySpeed[p] = 0;
+
+	/*Ensure that the particle doesn't overlap the goal, a wall or the limits if it is created next to them*/
+	collisions(l, p);
+
+	l->numberOfParticle++;
+
+	if (moving) l->numberOfMovingParticle++;
+	else invalidateStaticField(l);
+
+	return p;
+}
+
+Handle levelCreateWall(Level* l, const int x, const int y, const int w, const int h)
+{
+	int i;
+	Handle handle;
+
+	if (l->numberOfWall >= gMAX_WALL)
+	{
+		printf("ERROR: Number max of walls reached \n");
+		return gNULL_HANDLE;
+	}
+
+	/*Grow the wall array if it is full*/
+	if (l->numberOfWall == l->wallCapacity)
+	{
+		int32_t capacity = l->wallCapacity ? l->wallCapacity * 2 : 64;
+		if (capacity > gMAX_WALL) capacity = gMAX_WALL;
+
+		if (!reserveWalls(l, capacity)) return gNULL_HANDLE;
+	}
+
+	/*The new wall has the greatest index, so it is appended to the cells of the grid*/
+	if (!wallGridInsert(&l->wallGrid, l->numberOfWall, x, y, w, h))
+	{
+		printf("ERROR: Allocation of the wall grid failed \n");
+		rebuildWallGrid(l);
+		return gNULL_HANDLE;
+	}
+
+	handle = slotMapInsert(&l->wallSlots);
+	if (handle == gNULL_HANDLE)
+	{
+		rebuildWallGrid(l);
+		return gNULL_HANDLE;
+	}
+
+	l->wallArray[l->numberOfWall].x = x;
+	l->wallArray[l->numberOfWall].y = y;
+	l->wallArray[l->numberOfWall].w = w;
+	l->wallArray[l->numberOfWall].h = h;
+	l->numberOfWall++;
+
+	/*Move all the particles present in the created wall*/
+	for (i = 0; i < l->numberOfParticle; ++i) collisions(l, i);
+
+	return handle;
+}
+
+void levelSetGoal(Level* l, const int x, const int y, const int w, const int h)
+{
+	int i;
+
+	l->goal.x = x;
+	l->goal.y = y;
+	l->goal.w = w;
+	l->goal.h = h;
+
+	/*Move all the particles present in the created goal*/
+	for (i = 0; i < l->numberOfParticle; ++i) collisions(l, i);
+}
+
+void levelMoveParticle(Level* l, const int32_t p, const int x, const int y)
+{
+	if (!(l->particles.flags[p] & EParticleFlag_MOVING)) invalidateStaticField(l);
+
+	l->particles.xCoord[p] = (Real)x;
+	l->particles.yCoord[p] = (Real)y;
+	collisions(l, p);
+}
+
+void levelSetParticleCharge(Level* l, const int32_t p, const int32_t charge)
+{
+	if (!(l->particles.flags[p] & EParticleFlag_MOVING) && l->particles.charge[p] != charge) invalidateStaticField(l);
+
+	l->particles.charge[p] = charge;
+}
+
+
+/*----- DELETION FUNCTIONS -----*/
+bool levelDestroyParticle(Level* l, const int32_t p)
+{
+	if (p >= 0 && p < l->numberOfParticle && (l->particles.flags[p] & EParticleFlag_MODIFIABLE))
+	{
+		if (l->particles.flags[p] & EParticleFlag_MOVING) l->numberOfMovingParticle--;
+		else invalidateStaticField(l);
+
+		/*The last particle takes the index of the destroyed one, with its handle*/
+		copyParticle(l, p, slotMapRemove(&l->particleSlots, p));
+		l->numberOfParticle--;
+		return true;
+	}
+	return false;
+}
+
+void levelSwapParticles(Level* l, const int32_t p1, const int32_t p2)
+{
+	ParticleArray* a = &l->particles;
+	const Real xCoord = a->xCoord[p1], yCoord = a->yCoord[p1], xSpeed = a->xSpeed[p1], ySpeed = a->ySpeed[p1];
+	const Real xCoordInit = a->xCoordInit[p1], yCoordInit = a->yCoordInit[p1];
+	const Real xPrevious = a->xPrevious[p1], yPrevious = a->yPrevious[p1];
+	const int32_t charge = a->charge[p1];
+	const uint8_t flags = a->flags[p1];
+
+	copyParticle(l, p1, p2);
+	slotMapSwap(&l->particleSlots, p1, p2);
+
+	a->xCoord[p2] = xCoord;
+	a->yCoord[p2] = yCoord;
+	a->xSpeed[p2] = xSpeed;
+	a->ySpeed[p2] = ySpeed;
+	a->xCoordInit[p2] = xCoordInit;
+	a->yCoordInit[p2] = yCoordInit;
+	a->charge[p2] = charge;
+	a->flags[p2] = flags;
+	a->xPrevious[p2] = xPrevious;
+	a->yPrevious[p2] = yPrevious;
+}
+
+bool levelDestroyWall(Level* l, const Handle w)
+{
+	const int32_t i = slotMapIndex(&l->wallSlots, w);
+	int32_t last;
+
+	if (i < 0) return false;
+
+	/*The last wall takes the index of the destroyed one : only the cells of these two walls change*/
+	wallGridRemove(&l->wallGrid, i, l->wallArray[i].x, l->wallArray[i].y, l->wallArray[i].w, l->wallArray[i].h);
+	last = slotMapRemove(&l->wallSlots, i);
+	l->numberOfWall--;
+
+	if (last != i)
+	{
+		const Wall moved = l->wallArray[last];
+
+		wallGridRemove(&l->wallGrid, last, moved.x, moved.y, moved.w, moved.h);
+		l->wallArray[i] = moved;
+		if (!wallGridInsert(&l->wallGrid, i, moved.x, moved.y, moved.w, moved.h))
+		{
+			printf("ERROR: Allocation of the wall grid failed \n");
+			rebuildWallGrid(l);
+		}
+	}
+	return true;
+}
+
+Wall* levelWall(const Level* l, const Handle w)
+{
+	const int32_t i = slotMapIndex(&l->wallSlots, w);
+
+	return i < 0 ? NULL : &l->wallArray[i];
+}
+
+Handle levelParticleHandle(const Level* l, const int32_t p)
+{
+	return slotMapHandle(&l->particleSlots, p);
+}
+
+int32_t levelParticleIndex(const Level* l, const Handle p)
+{
+	return slotMapIndex(&l->particleSlots, p);
+}
+
+void levelDestroyGoal(Level* l)
+{
+	l->goal.x = 0;
+	l->goal.y = 0;
+	l->goal.w = 0;
+	l->goal.h = 0;
+}
+
+
+/*----- SIMULATION FUNCTIONS -----*/
+void levelStart(Level* l)
+{
+	l->running = true;
+	l->timeAccumulator = 0;
+
+	levelUpdateForceSolver(l);
+}
+
+void levelReset(Level* l)
+{
+	int i;
+
+	ParticleArray* a = &l->particles;
+
+	for (i = 0; i < l->numberOfParticle; ++i)
+	{
+		if (a->flags[i] & EParticleFlag_MOVING)
+		{
+			a->xCoord[i] = a->xCoordInit[i];
+			a->yCoord[i] = a->yCoordInit[i];
+			a->xSpeed[i] = 0;
+			a->ySpeed[i] = 0;
+			a->flags[i] &= (uint8_t)~EParticleFlag_GOAL;
+		}
+	}
+
+	l->numberOfParticlesOnGoal = 0;
+	l->running = false;
+	l->timeAccumulator = 0;
+}
+
+bool levelStep(Level* l, const double deltaTime)
+{
+	int i;
+	const int32_t numberOfParticlesOnGoal = l->numberOfParticlesOnGoal;
+	StepContext step;
+
+	if (!l->running) return false;
+
+	levelUpdateForceSolver(l);
+
+	/*Start the threads on the first step*/
+	startThreads(l);
+
+	/*Move the particles*/
+	step.l = l;
+	step.t = deltaTime * gTIME_MULTIPLIER;
+	threadPoolRun(l->threadPool, (l->numberOfParticle + gSTEP_TASK_SIZE - 1) / gSTEP_TASK_SIZE, stepTask, &step);
+
+	/*Count the particles on goal once all the tasks are done, in the same order whatever the number of threads*/
+	l->numberOfParticlesOnGoal = 0;
+	for (i = 0; i < l->numberOfParticle; ++i)
+	{
+		if (l->particles.flags[i] & EParticleFlag_GOAL) l->numberOfParticlesOnGoal++;
+	}
+
+	return l->numberOfParticlesOnGoal != numberOfParticlesOnGoal && levelIsFinished(l);
+}
+
+bool levelAdvance(Level* l, const double elapsedTime)
+{
+	int32_t steps = 0;
+	bool finished = false;
+
+	if (!l->running) return false;
+
+	l->timeAccumulator += elapsedTime;
+	while (l->timeAccumulator >= gPHYSICS_TIMESTEP && steps < gMAX_STEPS_PER_FRAME)
+	{
+		if (levelStep(l, gPHYSICS_TIMESTEP)) finished = true;
+		l->timeAccumulator -= gPHYSICS_TIMESTEP;
+		steps++;
+	}
+
+	/*Too late to catch up : drop the late steps, but keep the phase between two steps for the interpolation*/
+	if (l->timeAccumulator >= gPHYSICS_TIMESTEP) l->timeAccumulator = fmod(l->timeAccumulator, gPHYSICS_TIMESTEP);
+
+	return finished;
+}
+
+void levelInterpolatedPosition(const Level* l, const int32_t p, double* x, double* y)
+{
+	const ParticleArray* a = &l->particles;
+	const double alpha = l->timeAccumulator / gPHYSICS_TIMESTEP;
+
+	if (!l->running || !(a->flags[p] & EParticleFlag_MOVING))
+	{
+		*x = a->xCoord[p];
+		*y = a->yCoord[p];
+		return;
+	}
+
+	*x = a->xPrevious[p] + (a->xCoord[p] - a->xPrevious[p]) * alpha;
+	*y = a->yPrevious[p] + (a->yCoord[p] - a->yPrevious[p]) * alpha;
+}
+
+void levelChooseForceSolver(Level* l)
+{
+	const int64_t numberOfMovingParticles = l->numberOfMovingParticle;
+	const int64_t numberOfFixedParticles = l->numberOfParticle - l->numberOfMovingParticle;
+
+	if (numberOfMovingParticles * l->numberOfParticle < gDIRECT_SUM_MAX_INTERACTIONS) levelSetForceSolver(l, EForceSolver_DIRECT);
+	else if (numberOfMovingParticles >= numberOfFixedParticles) levelSetForceSolver(l, EForceSolver_BARNES_HUT);
+	else levelSetForceSolver(l, EForceSolver_STATIC_FIELD);
+}
+
+void levelSetForceSolver(Level* l, const EForceSolver forceSolver)
+{
+	l->forceSolver = forceSolver;
+}
+
+void levelSetOpeningAngle(Level* l, const double openingAngle)
+{
+	/*The static field of more than gFORCE_FIELD_QUADTREE_THRESHOLD particles is rasterized with this angle*/
+	if (openingAngle != l->openingAngle) invalidateStaticField(l);
+
+	l->openingAngle = openingAngle;
+}
+
+void levelSetNumberOfThreads(Level* l, const int32_t numberOfThreads)
+{
+	const int32_t n = numberOfThreads > 0 ? numberOfThreads : threadPoolNumberOfCores();
+
+	if (n != l->numberOfThreads)
+	{
+		threadPoolDestroy(l->threadPool);
+		l->threadPool = NULL;
+		l->numberOfThreads = n;
+	}
+}
+
+bool levelIsFinished(const Level* l)
+{
+	return l->numberOfMovingParticle > 0 && l->numberOfParticlesOnGoal == l->numberOfMovingParticle;
+}
+
+void levelUpdateForceSolver(Level* l)
+{
+	int i, numberOfMovingParticles = 0, numberOfFixedParticles = 0;
+	const ParticleArray* a = &l->particles;
+
+	/*The forces are computed from a copy of the positions, so that moving a particle doesn't change the forces of the others*/
+	if (l->numberOfParticle > 0)
+	{
+		memcpy(a->xPrevious, a->xCoord, l->numberOfParticle * sizeof(Real));
+		memcpy(a->yPrevious, a->yCoord, l->numberOfParticle * sizeof(Real));
+	}
+
+	switch (l->forceSolver)
+	{
+	case EForceSolver_BARNES_HUT:
+		if (!quadtreeBuild(&l->quadtree, a->xPrevious, a->yPrevious, a->charge, l->numberOfParticle))
+		{
+			printf("ERROR: Can't build the quadtree, falling back to the direct sum \n");
+			l->forceSolver = EForceSolver_DIRECT;
+		}
+		break;
+
+	case EForceSolver_STATIC_FIELD:
+		/*Gather the moving particles, their forces are summed directly*/
+		if (l->numberOfMovingParticle > l->movingParticleCapacity)
+		{
+			Real* xMoving = (Real*)realloc(l->xMoving, l->numberOfMovingParticle * sizeof(Real));
+			if (xMoving) l->xMoving = xMoving;
+			Real* yMoving = (Real*)realloc(l->yMoving, l->numberOfMovingParticle * sizeof(Real));
+			if (yMoving) l->yMoving = yMoving;
+			int32_t* chargeMoving = (int32_t*)realloc(l->chargeMoving, l->numberOfMovingParticle * sizeof(int32_t));
+			if (chargeMoving) l->chargeMoving = chargeMoving;
+
+			if (!xMoving || !yMoving || !chargeMoving)
+			{
+				printf("ERROR: Can't gather the moving particles, falling back to the direct sum \n");
+				l->forceSolver = EForceSolver_DIRECT;
+				break;
+			}
+			l->movingParticleCapacity = l->numberOfMovingParticle;
+		}
+		for (i = 0; i < l->numberOfParticle; ++i)
+		{
+			if (a->flags[i] & EParticleFlag_MOVING)
+			{
+				l->xMoving[numberOfMovingParticles] = a->xPrevious[i];
+				l->yMoving[numberOfMovingParticles] = a->yPrevious[i];
+				l->chargeMoving[numberOfMovingParticles] = a->charge[i];
+				numberOfMovingParticles++;
+			}
+		}
+
+		/*Rasterize the field of the non moving particles, unless it is up to date or failed for these particles*/
+		if (!l->staticFieldReady && !l->staticFieldFailed)
+		{
+			const int32_t n = l->numberOfParticle + 1;
+			Real* xFixed = (Real*)malloc(n * (2 * sizeof(Real) + sizeof(int32_t)));
+			if (!xFixed)
+			{
+				printf("ERROR: Can't build the static field, falling back to the direct sum \n");
+				l->staticFieldFailed = true;
+				break;
+			}
+			Real* yFixed = xFixed + n;
+			int32_t* chargeFixed = (int32_t*)(yFixed + n);
+
+			for (i = 0; i < l->numberOfParticle; ++i)
+			{
+				if (!(a->flags[i] & EParticleFlag_MOVING))
+				{
+					xFixed[numberOfFixedParticles] = a->xCoord[i];
+					yFixed[numberOfFixedParticles] = a->yCoord[i];
+					chargeFixed[numberOfFixedParticles] = a->charge[i];
+					numberOfFixedParticles++;
+				}
+			}
+
+			startThreads(l);
+			l->staticFieldReady = forceFieldBuild(&l->staticField, xFixed, yFixed, chargeFixed, numberOfFixedParticles,
+			                                      l->width, l->height, l->staticFieldCellSize, l->openingAngle, l->threadPool);
+			if (!l->staticFieldReady)
+			{
+				printf("ERROR: Can't build the static field, falling back to the direct sum \n");
+				l->staticFieldFailed = true;
+			}
+
+			free(xFixed);
+		}
+		break;
+
+	default: ;
+	}
+}
+
+void levelForceError(Level* l, double* rmsError, double* maxError)
+{
+	double sumSquaredErrors = 0, maximum = 0;
+	int numberOfSamples = 0;
+	int i;
+
+	levelUpdateForceSolver(l);
+
+	for (i = 0; i < l->numberOfParticle; ++i)
+	{
+		double directX, directY, approximateX, approximateY;
+
+		if (!(l->particles.flags[i] & EParticleFlag_MOVING)) continue;
+
+		getDirectForce(l, i, &directX, &directY);
+		getSolverForce(l, i, &approximateX, &approximateY);
+
+		const double norm = sqrt(directX * directX + directY * directY);
+		if (norm > 0)
+		{
+			const double error = sqrt(pow(approximateX - directX, 2) + pow(approximateY - directY, 2)) / norm;
+			sumSquaredErrors += error * error;
+			maximum = fmax(maximum, error);
+			numberOfSamples++;
+		}
+	}
+
+	if (rmsError) *rmsError = numberOfSamples ? sqrt(sumSquaredErrors / numberOfSamples) : 0;
+	if (maxError) *maxError = maximum;
+}
+
+void getAcceleration(const Level* l, const int32_t p, double* ax, double* ay)
+{
+	double sumForcesX, sumForcesY;
+
+	getSolverForce(l, p, &sumForcesX, &sumForcesY);
+
+	*ax = sumForcesX * gPARTICLE_MASS;
+	clamp(ax, gMAX_ACCELERATION);
+
+	*ay = sumForcesY * gPARTICLE_MASS;
+	clamp(ay, gMAX_ACCELERATION);
+}
+
+static void getSolverForce(const Level* l, const int32_t p, double* fx, double* fy)
+{
+	const double x = l->particles.xPrevious[p];
+	const double y = l->particles.yPrevious[p];
+	const int32_t charge = l->particles.charge[p];
+	double ex, ey;
+
+	switch (l->forceSolver)
+	{
+	case EForceSolver_BARNES_HUT:
+		quadtreeForce(&l->quadtree, p, x, y, charge, l->openingAngle, fx, fy);
+		break;
+
+	case EForceSolver_STATIC_FIELD:
+		if (!l->staticFieldReady)
+		{
+			getDirectForce(l, p, fx, fy);
+			break;
+		}
+
+		/*Field of the non moving particles, plus the field of the moving particles. The particle itself has no effect*/
+		forceFieldSample(&l->staticField, x, y, fx, fy);
+		forceKernelField(l->xMoving, l->yMoving, l->chargeMoving, l->numberOfMovingParticle, x, y, &ex, &ey);
+
+		*fx = charge * (*fx + ex);
+		*fy = charge * (*fy + ey);
+		break;
+
+	default:
+		getDirectForce(l, p, fx, fy);
+	}
+}
+
+static void getDirectForce(const Level* l, const int32_t p, double* fx, double* fy)
+{
+	const ParticleArray* a = &l->particles;
+	double ex, ey;
+
+	/*The particle itself has no effect : no need to skip it*/
+	forceKernelField(a->xPrevious, a->yPrevious, a->charge, l->numberOfParticle, a->xPrevious[p], a->yPrevious[p], &ex, &ey);
+
+	*fx = a->charge[p] * ex;
+	*fy = a->charge[p] * ey;
+}
+
+void collisions(Level* l, const int32_t p)
+{
+	int32_t i = -1;
+	const int r = l->particleRadius;
+	const Goal* g = &l->goal;
+	ParticleArray* a = &l->particles;
+
+	if (p >= 0)
+	{
+		double xCoord = a->xCoord[p], yCoord = a->yCoord[p];
+		double xSpeed = a->xSpeed[p], ySpeed = a->ySpeed[p];
+
+		/*Collisions with the walls near the particle, in the order of the wall array. The walls near are searched again after each wall, as the particle may have been pushed*/
+		while ((i = wallGridNext(&l->wallGrid, (int)xCoord - r, (int)yCoord - r, (int)xCoord + r, (int)yCoord + r, i)) != -1)
+		{
+			const Wall* w = &l->wallArray[i];
+
+			if (xSpeed >= 0 && rectHitbox(w->x, w->y, w->w, w->h, xCoord, yCoord, r, 0, 0, 0))
+			{
+				xSpeed = 0;
+				xCoord = w->x - r;
+			}
+
+			if (xSpeed <= 0 && rectHitbox(w->x, w->y, w->w, w->h, xCoord, yCoord, 0, r, 0, 0))
+			{
+				xSpeed = 0;
+				xCoord = w->x + w->w + r;
+			}
+
+			if (ySpeed >= 0 && rectHitbox(w->x, w->y, w->w, w->h, xCoord, yCoord, 0, 0, r, 0))
+			{
+				ySpeed = 0;
+				yCoord = w->y - r;
+			}
+
+			if (ySpeed <= 0 && rectHitbox(w->x, w->y, w->w, w->h, xCoord, yCoord, 0, 0, 0, r))
+			{
+				ySpeed = 0;
+				yCoord = w->y + w->h + r;
+			}
+		}
+
+		/*Collisions with the goal*/
+		if (!(a->flags[p] & EParticleFlag_MOVING) || (l->creativeMode && !l->running))
+		{
+			if (xSpeed >= 0 && rectHitbox(g->x, g->y, g->w, g->h, xCoord, yCoord, r, 0, 0, 0))
+			{
+				xSpeed = 0;
+				xCoord = g->x - r;
+			}
+
+			if (xSpeed <= 0 && rectHitbox(g->x, g->y, g->w, g->h, xCoord, yCoord, 0, r, 0, 0))
+			{
+				xSpeed = 0;
+				xCoord = g->x + g->w + r;
+			}
+
+			if (ySpeed >= 0 && rectHitbox(g->x, g->y, g->w, g->h, xCoord, yCoord, 0, 0, r, 0))
+			{
+				ySpeed = 0;
+				yCoord = g->y - r;
+			}
+
+			if (ySpeed <= 0 && rectHitbox(g->x, g->y, g->w, g->h, xCoord, yCoord, 0, 0, 0, r))
+			{
+				ySpeed = 0;
+				yCoord = g->y + g->h + r;
+			}
+		}
+
+		/*Collisions with the limits playable*/
+		if (xSpeed >= 0 && xCoord >= l->width - r)
+		{
+			xSpeed = 0;
+			xCoord = l->width - r;
+		}
+
+		if (xSpeed <= 0 && xCoord <= 0 + r)
+		{
+			xSpeed = 0;
+			xCoord = 0 + r;
+		}
+
+		if (ySpeed >= 0 && yCoord >= l->height - r)
+		{
+			ySpeed = 0;
+			yCoord = l->height - r;
+		}
+
+		if (ySpeed <= 0 && yCoord <= 0 + r)
+		{
+			ySpeed = 0;
+			yCoord = 0 + r;
+		}
+
+		/*A non moving particle pushed by a new wall or goal changes the static field*/
+		if (!(a->flags[p] & EParticleFlag_MOVING) && ((Real)xCoord != a->xCoord[p] || (Real)yCoord != a->yCoord[p])) invalidateStaticField(l);
+
+		a->xCoord[p] = (Real)xCoord;
+		a->yCoord[p] = (Real)yCoord;
+		a->xSpeed[p] = (Real)xSpeed;
+		a->ySpeed[p] = (Real)ySpeed;
+	}
+}
+
+bool onGoal(Level* l, const int32_t p)
+{
+	if (!(l->particles.flags[p] & EParticleFlag_GOAL) && isOnGoal(l, p))
+	{
+		l->particles.flags[p] |= EParticleFlag_GOAL;
+		l->numberOfParticlesOnGoal++;
+		return true;
+	}
+	return false;
+}
+
+
+/*----- QUERY FUNCTIONS -----*/
+int32_t levelParticleAt(const Level* l, const int x, const int y)
+{
+	int i;
+	const int r = l->particleRadius;
+
+	for (i = l->numberOfParticle - 1; i >= 0; --i)
+	{
+		const int dx = (int)l->particles.xCoord[i] - x;
+		const int dy = (int)l->particles.yCoord[i] - y;
+
+		if (dx * dx + dy * dy < r * r) return i;
+	}
+	return -1;
+}
+
+Handle levelWallAt(const Level* l, const int x, const int y)
+{
+	int32_t i = -1;
+
+	while ((i = wallGridNext(&l->wallGrid, x, y, x, y, i)) != -1)
+	{
+		const Wall* w = &l->wallArray[i];
+		if (rectHitbox(w->x, w->y, w->w, w->h, x, y, 0, 0, 0, 0)) return slotMapHandle(&l->wallSlots, i);
+	}
+	return gNULL_HANDLE;
+}
+
+bool levelGoalAt(const Level* l, const int x, const int y)
+{
+	return rectHitbox(l->goal.x, l->goal.y, l->goal.w, l->goal.h, x, y, 0, 0, 0, 0);
+}
+
+
+/*----- LEVEL FILES -----*/
+bool levelLoad(Level* l, const char* filename, bool modifiable, int32_t highScores[3])
+{
+	LevelFile f;
+	int32_t i;
+
+	if (!levelFileOpen(&f, filename)) return false;
+
+	const LevelFileHeader* h = f.header;
+
+	levelFree(l);
+
+	/*Loading of the high scores and of the goal position*/
+	if (highScores) memcpy(highScores, h->highScores, sizeof(h->highScores));
+	levelSetGoal(l, h->goal[0], h->goal[1], h->goal[2], h->goal[3]);
+
+	/*All the arrays at their final size at once*/
+	if (!reserveParticles(l, h->numberOfMovingParticles + h->numberOfNonMovingParticles) || !reserveWalls(l, h->numberOfWalls))
+	{
+		printf("ERROR: Allocation of the level %s failed \n", filename);
+		levelFileClose(&f);
+		levelFree(l);
+		return false;
+	}
+
+	/*Loading of the walls positions, before the particles : each particle is then moved out of the walls once, when it is created*/
+	for (i = 0; i < h->numberOfWalls; ++i)
+	{
+		const int32_t* w = &f.walls[4 * i];
+		levelCreateWall(l, w[0], w[1], w[2], w[3]);
+	}
+
+	/*Loading of the moving particles*/
+	for (i = 0; i < h->numberOfMovingParticles; ++i)
+	{
+		const int32_t* p = &f.movingParticles[2 * i];
+		levelCreateParticle(l, true, modifiable, 1, p[0], p[1]);
+	}
+
+	/*Loading of the non moving particles*/
+	for (i = 0; i < h->numberOfNonMovingParticles; ++i)
+	{
+		const int32_t* p = &f.nonMovingParticles[3 * i];
+		levelCreateParticle(l, false, modifiable, p[2], p[0], p[1]);
+	}
+
+	levelFileClose(&f);
+	return true;
+}
+
+bool levelSave(const Level* l, const char* filename, bool saveModifiableParticles, const int32_t highScores[3], const ELevelFormat format)
+{
+	LevelFile f;
+	int32_t i, moving = 0, nonMoving = 0;
+	int32_t numberOfNonMovingParticles = 0;
+	const ParticleArray* a = &l->particles;
+
+	for (i = 0; i < l->numberOfParticle; ++i)
+	{
+		if (!(a->flags[i] & EParticleFlag_MOVING) && (saveModifiableParticles || !(a->flags[i] & EParticleFlag_MODIFIABLE)))
+			numberOfNonMovingParticles++;
+	}
+
+	if (!levelFileCreate(&f, l->numberOfMovingParticle, numberOfNonMovingParticles, l->numberOfWall)) return false;
+
+	/*Saving of the high scores and of the goal position*/
+	memcpy(f.header->highScores, highScores, sizeof(f.header->highScores));
+	f.header->goal[0] = l->goal.x;
+	f.header->goal[1] = l->goal.y;
+	f.header->goal[2] = l->goal.w;
+	f.header->goal[3] = l->goal.h;
+
+	/*Saving the moving particles at their initial position, and the non moving particles*/
+	for (i = 0; i < l->numberOfParticle; ++i)
+	{
+		if (a->flags[i] & EParticleFlag_MOVING)
+		{
+			f.movingParticles[2 * moving] = (int32_t)a->xCoordInit[i];
+			f.movingParticles[2 * moving + 1] = (int32_t)a->yCoordInit[i];
+			moving++;
+		}
+		else if (saveModifiableParticles || !(a->flags[i] & EParticleFlag_MODIFIABLE))
+		{
+			f.nonMovingParticles[3 * nonMoving] = (int32_t)a->xCoord[i];
+			f.nonMovingParticles[3 * nonMoving + 1] = (int32_t)a->yCoord[i];
+			f.nonMovingParticles[3 * nonMoving + 2] = a->charge[i];
+			nonMoving++;
+		}
+	}
+
+	/*Saving the walls positions*/
+	for (i = 0; i < l->numberOfWall; ++i)
+	{
+		f.walls[4 * i] = l->wallArray[i].x;
+		f.walls[4 * i + 1] = l->wallArray[i].y;
+		f.walls[4 * i + 2] = l->wallArray[i].w;
+		f.walls[4 * i + 3] = l->wallArray[i].h;
+	}
+
+	const bool written = levelFileWrite(&f, filename, format);
+	levelFileClose(&f);
+	return written;
+}
+
+
+/*----- OTHER FUNCTIONS -----*/
+void clamp(double* value, const double limit)
+{
+	if (*value < -limit) *value = -limit;
+	else if (*value > limit) *value = limit;
+}
+
+double getDistance(const Level* l, const int32_t p1, const int32_t p2)
+{
+	return sqrt(pow(l->particles.xCoord[p1] - l->particles.xCoord[p2], 2)
+		+ pow(l->particles.yCoord[p1] - l->particles.yCoord[p2], 2));
+}
@@ -0,0 +1,452 @@
+#ifndef CHARGECORE_H
+#define CHARGECORE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "forcekernel.h"
+#include "quadtree.h"
+#include "forcefield.h"
+#include "threadpool.h"
+#include "wallgrid.h"
+#include "slotmap.h"
+#include "arena.h"
+#include "levelfile.h"
+
+
+/*----- CONSTANTS -----*/
+/** \brief Number of particles a level can hold. The particle array grows on demand up to this limit*/
+#define gMAX_PARTICLES 100000
+
+/** \brief Number of walls a level can hold. The wall array grows on demand up to this limit*/
+#define gMAX_WALL 50000
+
+/** \brief Number of consecutive particles moved by one task of the parallel step. See levelStep()*/
+#define gSTEP_TASK_SIZE 64
+
+/** \brief Maximum charge of a particle. If changed, be sure to create the corresponding SDL_Surfaces and images*/
+extern const int32_t gMAX_PARTICULE_CHARGE;
+
+/** \brief Minimum charge of a particle. If changed, be sure to create the corresponding SDL_Surfaces and images*/
+extern const int32_t gMIN_PARTICULE_CHARGE;
+
+/** \brief Maximum speed of a moving particle. Used to clamp the particle speed in levelStep()*/
+extern const double gMAX_SPEED;
+
+/** \brief Maximum acceleration of a moving particle. Used to clamp the particle acceleration in getAcceleration()*/
+extern const double gMAX_ACCELERATION;
+
+/** \brief Mass of a particle. Used in getAcceleration()*/
+extern const int32_t gPARTICLE_MASS;
+
+/** \brief Minimum distance at which the force between two particles is calculated by : f = C1C2/d^2.
+ * Below that limit, the calculation is done with the distance equals to this constant, in order to avoid infinites forces*/
+extern const double gMIN_DISTANCE;
+
+/** \brief Time multiplier of the game. Used to modify the overall speed of the particles movement*/
+extern const double gTIME_MULTIPLIER;
+
+/** \brief Duration of a physics step, in milliseconds. levelAdvance() only steps the levels by this duration*/
+extern const double gPHYSICS_TIMESTEP;
+
+/** \brief Maximum number of physics steps run by one call to levelAdvance(). The time left beyond is dropped*/
+extern const int32_t gMAX_STEPS_PER_FRAME;
+
+/** \brief Default opening angle of the Barnes-Hut force solver. See quadtreeForce()*/
+extern const double gDEFAULT_OPENING_ANGLE;
+
+/** \brief Number of interactions summed by a step (moving particles times all the particles) below which levelChooseForceSolver()
+ * keeps the direct sum. Below, the direct sum of a whole run costs less than the quadtree or the static field*/
+extern const int64_t gDIRECT_SUM_MAX_INTERACTIONS;
+
+
+/*----- ENUMERATIONS -----*/
+/** \brief Algorithms available to sum the forces applied on a particle*/
+typedef enum EForceSolver
+{
+	EForceSolver_DIRECT, //Sum the force of every particle : O(N) per particle, exact
+	EForceSolver_BARNES_HUT, //Approximate far particles with a quadtree : O(log N) per particle
+	EForceSolver_STATIC_FIELD //Sample the field of the non moving particles, rasterized again when they change, and sum the moving ones : O(M) per particle
+} EForceSolver;
+
+
+/** \brief States of a particle, combined in the flags array of the particles*/
+typedef enum EParticleFlag
+{
+	EParticleFlag_MOVING = 1 << 0, //The particle is a moving particle
+	EParticleFlag_MODIFIABLE = 1 << 1, //The particle can be modified by the player when in normal game
+	EParticleFlag_GOAL = 1 << 2 //The particle is on the goal (used only for moving particles)
+} EParticleFlag;
+
+
+/*----- STRUCTURES -----*/
+/** \brief Structure of the particles of a level, stored as one contiguous array per parameter.
+ * A particle is identified by its index in the arrays, so that the force loops read the coordinates and charges without indirection
+ * \param xCoord : x coordinates. Stored as floating point values for smoother movements
+ * \param yCoord : y coordinates. Stored as floating point values for smoother movements
+ * \param xSpeed : x speeds
+ * \param ySpeed : y speeds
+ * \param xCoordInit : initial x coordinates. Used to reset the particle positions when reseting the level
+ * \param yCoordInit : initial y coordinates. Used to reset the particle positions when reseting the level
+ * \param charge : charges of the particles. Vary between gMIN_PARTICLE_CHARGE and gMAX_PARTICLE_CHARGE
+ * \param flags : states of the particles, combination of EParticleFlag
+ * \param xPrevious : x coordinates copied by levelUpdateForceSolver() at the beginning of a step. The force solvers only read these ones.
+ * After the step, they are the previous physics state used by levelInterpolatedPosition()
+ * \param yPrevious : y coordinates copied by levelUpdateForceSolver() at the beginning of a step. See xPrevious*/
+typedef struct ParticleArray
+{
+	Real* xCoord;
+	Real* yCoord;
+	Real* xSpeed;
+	Real* ySpeed;
+	Real* xCoordInit;
+	Real* yCoordInit;
+	int32_t* charge;
+	uint8_t* flags;
+	Real* xPrevious;
+	Real* yPrevious;
+} ParticleArray;
+
+
+/** \brief Structure of a wall
+ * \param x : x coordinate of the uper left wedge of the wall
+ * \param y : y coordinate of the uper left wedge of the wall
+ * \param w : x length of the wall
+ * \param h	: y lenght of the wall*/
+typedef struct Wall
+{
+	int x;
+	int y;
+	int w;
+	int h;
+} Wall;
+
+
+/** \brief Structure of the goal. Same layout as a SDL_Rect, without depending on SDL
+ * \param x : x coordinate of the uper left wedge of the goal
+ * \param y : y coordinate of the uper left wedge of the goal
+ * \param w : x length of the goal
+ * \param h : y length of the goal*/
+typedef struct Goal
+{
+	int x;
+	int y;
+	int w;
+	int h;
+} Goal;
+
+
+/** \brief Structure of a level : everything the simulation needs to step a level, without any SDL dependency.
+ * A level must not be moved in memory after levelInit() : its slot maps and its wall grid point to its arena
+ * \param arena : memory of the particles, the walls, their handles and the wall grid, freed at once by levelFree()
+ * \param particles : particles of the level. The arrays are compact, in no particular order
+ * \param particleSlots : handles of the particles, which stay valid when the particles change of index
+ * \param particleCapacity : number of particles allocated in the arrays of particles
+ * \param numberOfParticle : overall number of particles present in the level
+ * \param numberOfMovingParticle : number of moving particles present in the level
+ * \param numberOfParticlesOnGoal : number of moving particles already in the goal
+ * \param wallArray : walls of the level. The array is compact, in no particular order
+ * \param wallSlots : handles of the walls, which stay valid when the walls change of index
+ * \param wallCapacity : number of walls allocated in wallArray
+ * \param numberOfWall : number of walls present in the level
+ * \param wallGrid : indices in wallArray of the walls overlapping each cell of the playable area, used by collisions() and levelWallAt()
+ * \param goal : position of the goal. A goal with w == 0 or h == 0 does not exist
+ * \param width : width of the playable area
+ * \param height : height of the playable area
+ * \param particleRadius : radius of the particles. All the particles have the same size
+ * \param running : true between levelStart() and levelReset(). When running, moving particles are not blocked by the goal
+ * \param creativeMode : true if the level is being edited. When not running, moving particles are then blocked by the goal
+ * \param forceSolver : algorithm used by getAcceleration(). EForceSolver_DIRECT by default, see levelSetForceSolver()
+ * \param openingAngle : opening angle of the Barnes-Hut force solver and of the quadtree of the static field. gDEFAULT_OPENING_ANGLE by default, see levelSetOpeningAngle()
+ * \param quadtree : quadtree of the Barnes-Hut force solver, rebuilt by levelUpdateForceSolver()
+ * \param staticField : field of the non moving particles, used by the static field force solver
+ * \param staticFieldCellSize : distance between two samples of staticField. gFORCE_FIELD_CELL_SIZE by default
+ * \param staticFieldReady : true if staticField matches the non moving particles. Set by levelUpdateForceSolver(), cleared when a non moving particle is created, destroyed, moved or changes of charge
+ * \param staticFieldFailed : true if the last rasterization of staticField failed. The direct sum is then used until the non moving particles change
+ * \param xMoving : x coordinates of the moving particles, gathered by levelUpdateForceSolver() for the static field force solver
+ * \param yMoving : y coordinates of the moving particles
+ * \param chargeMoving : charges of the moving particles
+ * \param movingParticleCapacity : number of particles allocated in xMoving, yMoving and chargeMoving
+ * \param numberOfThreads : number of threads moving the particles in levelStep(). 1 by default, see levelSetNumberOfThreads()
+ * \param threadPool : threads of levelStep() and of the static field, created on their first use with numberOfThreads > 1. NULL otherwise
+ * \param timeAccumulator : time given to levelAdvance() and not simulated yet, in milliseconds. Always below gPHYSICS_TIMESTEP*/
+typedef struct Level
+{
+	Arena arena;
+	ParticleArray particles;
+	SlotMap particleSlots;
+	int32_t particleCapacity;
+	int32_t numberOfParticle;
+	int32_t numberOfMovingParticle;
+	int32_t numberOfParticlesOnGoal;
+	Wall* wallArray;
+	SlotMap wallSlots;
+	int32_t wallCapacity;
+	int32_t numberOfWall;
+	WallGrid wallGrid;
+	Goal goal;
+	int width;
+	int height;
+	int particleRadius;
+	bool running;
+	bool creativeMode;
+	EForceSolver forceSolver;
+	double openingAngle;
+	Quadtree quadtree;
+	ForceField staticField;
+	double staticFieldCellSize;
+	bool staticFieldReady;
+	bool staticFieldFailed;
+	Real* xMoving;
+	Real* yMoving;
+	int32_t* chargeMoving;
+	int32_t movingParticleCapacity;
+	int32_t numberOfThreads;
+	ThreadPool* threadPool;
+	double timeAccumulator;
+} Level;
+
+
+/*----- FUNCTION PROTOTYPES -----*/
+/** \brief Initialize an empty level
+ * \param l : level to initialize
+ * \param width : width of the playable area
+ * \param height : height of the playable area
+ * \param particleRadius : radius of the particles*/
+void levelInit(Level* l, const int width, const int height, const int particleRadius);
+
+/** \brief Free all the particles and walls of a level in one reset of its arena, remove its goal, free the buffers of the force solver and stop its threads.
+ * The level can be used again afterwards, with the same force solver and number of threads. The high-water mark of the arena is kept
+ * \param l : level to free*/
+void levelFree(Level* l);
+
+/** \brief Add a particle at the end of the particle arrays. The arrays grow if they are full
+ * \param l : level in which the particle is created
+ * \param moving : state of the particle, see EParticleFlag
+ * \param modifiable : state of the particle, see EParticleFlag
+ * \param charge : charge of the particle
+ * \param x : x coordinate of the particle
+ * \param y : y coordinate of the particle
+ * \return index of the created particle. Return -1 if the level is full or if the allocation failed*/
+int32_t levelCreateParticle(Level* l, bool moving, bool modifiable, const int32_t charge, const int x, const int y);
+
+/** \brief Add a wall at the end of the wall array. The array grows if it is full.
+ * All the particles overlapping the new wall are pushed out of it
+ * \param l : level in which the wall is created
+ * \param x : wall parameter, see wall structure
+ * \param y : wall parameter, see wall structure
+ * \param w : wall parameter, see wall structure
+ * \param h : wall parameter, see wall structure
+ * \return handle of the created wall. Return gNULL_HANDLE if the level is full or if the allocation failed*/
+Handle levelCreateWall(Level* l, const int x, const int y, const int w, const int h);
+
+/** \brief Set the goal of a level. All the particles overlapping the new goal are pushed out of it
+ * \param l : level to modify
+ * \param x : see goal structure
+ * \param y : see goal structure
+ * \param w : see goal structure
+ * \param h : see goal structure*/
+void levelSetGoal(Level* l, const int x, const int y, const int w, const int h);
+
+/** \brief Move a particle, then push it out of the walls, the goal and the limits of the playable area.
+ * Moving a non moving particle invalidates the static field
+ * \param l : level containing the particle
+ * \param p : index of the particle
+ * \param x : new x coordinate
+ * \param y : new y coordinate*/
+void levelMoveParticle(Level* l, const int32_t p, const int x, const int y);
+
+/** \brief Change the charge of a particle. Changing the charge of a non moving particle invalidates the static field
+ * \param l : level containing the particle
+ * \param p : index of the particle
+ * \param charge : new charge*/
+void levelSetParticleCharge(Level* l, const int32_t p, const int32_t charge);
+
+/** \brief Remove the particle passed as input parameter if it is modifiable. The last particle takes its index, with its handle
+ * \param l : level containing the particle
+ * \param p : index of the particle to destroy
+ * \return true if the particle was destroyed*/
+bool levelDestroyParticle(Level* l, const int32_t p);
+
+/** \brief Exchange the indices of two particles. Their handles follow them
+ * \param l : level containing the particles
+ * \param p1 : index of the first particle
+ * \param p2 : index of the second particle*/
+void levelSwapParticles(Level* l, const int32_t p1, const int32_t p2);
+
+/** \brief Remove a wall. The last wall takes its index, with its handle
+ * \param l : level containing the wall
+ * \param w : handle of the wall to destroy
+ * \return true if the wall was destroyed, false if the handle is stale*/
+bool levelDestroyWall(Level* l, const Handle w);
+
+/** \brief Get a wall from its handle
+ * \param l : level containing the wall
+ * \param w : handle of the wall
+ * \return pointer to the wall, valid until the next creation or destruction of a wall. NULL if the handle is stale*/
+Wall* levelWall(const Level* l, const Handle w);
+
+/** \brief Get the handle of a particle. Unlike its index, it stays valid until the particle is destroyed
+ * \param l : level containing the particle
+ * \param p : index of the particle
+ * \return handle of the particle. gNULL_HANDLE if there is no particle at this index*/
+Handle levelParticleHandle(const Level* l, const int32_t p);
+
+/** \brief Get the current index of a particle from its handle
+ * \param l : level containing the particle
+ * \param p : handle of the particle
+ * \return index of the particle. -1 if the handle is stale*/
+int32_t levelParticleIndex(const Level* l, const Handle p);
+
+/** \brief Set the goal of a level to an empty surface
+ * \param l : level to modify*/
+void levelDestroyGoal(Level* l);
+
+/** \brief Start the simulation of the level. levelStep() only moves particles once the level is started.
+ * In EForceSolver_STATIC_FIELD mode, the field of the non moving particles is rasterized here if they changed since it was last rasterized
+ * \param l : level to start*/
+void levelStart(Level* l);
+
+/** \brief Stop the simulation. Get the moving particles back to their initial coordinates, with a speed of 0.
+ * Reset the number of particles on goal to 0
+ * \param l : level to reset*/
+void levelReset(Level* l);
+
+/** \brief Compute the movements of the moving particles of a started level during a time step.
+ * All the accelerations are computed from the positions at the beginning of the step, so the particles can be moved in parallel,
+ * by tasks of gSTEP_TASK_SIZE particles. The result doesn't depend on the number of threads
+ * \param l : level to step
+ * \param deltaTime : duration of the step, in milliseconds. Multiplied by gTIME_MULTIPLIER
+ * \return true if this step brought the last moving particle on the goal*/
+bool levelStep(Level* l, const double deltaTime);
+
+/** \brief Advance the simulation of a started level by some elapsed time, with steps of gPHYSICS_TIMESTEP only.
+ * The time which is not a multiple of gPHYSICS_TIMESTEP is kept for the next call. At most gMAX_STEPS_PER_FRAME steps are run,
+ * so a slow frame slows the simulation down instead of changing the trajectories
+ * \param l : level to advance
+ * \param elapsedTime : time elapsed since the last call, in milliseconds
+ * \return true if these steps brought the last moving particle on the goal*/
+bool levelAdvance(Level* l, const double elapsedTime);
+
+/** \brief Get the position at which a particle should be drawn : between its positions before and after the last step of levelAdvance(),
+ * in proportion of the time accumulated since that step. Outside a started level, the current position of the particle
+ * \param l : level containing the particle
+ * \param p : index of the particle
+ * \param x : pointer to output parameter x coordinate
+ * \param y : pointer to output parameter y coordinate*/
+void levelInterpolatedPosition(const Level* l, const int32_t p, double* x, double* y);
+
+/** \brief Pick the force solver of a level from its size. Below gDIRECT_SUM_MAX_INTERACTIONS, EForceSolver_DIRECT.
+ * Above, EForceSolver_BARNES_HUT if there are at least as many moving particles as non moving ones : the static field still sums
+ * the moving particles directly, in O(M^2). EForceSolver_STATIC_FIELD otherwise
+ * \param l : level to modify*/
+void levelChooseForceSolver(Level* l);
+
+/** \brief Set the algorithm used by getAcceleration() to sum the forces applied on a particle
+ * \param l : level to modify
+ * \param forceSolver : force solver. Its buffers are built by the next levelUpdateForceSolver()*/
+void levelSetForceSolver(Level* l, const EForceSolver forceSolver);
+
+/** \brief Set the opening angle of the Barnes-Hut force solver and of the quadtree of the static field. See quadtreeForce()
+ * \param l : level to modify
+ * \param openingAngle : opening angle. 0 gives the direct sum, greater angles are faster and less precise*/
+void levelSetOpeningAngle(Level* l, const double openingAngle);
+
+/** \brief Set the number of threads moving the particles in levelStep()
+ * \param l : level to modify
+ * \param numberOfThreads : number of threads, including the thread calling levelStep(). 0 or less : one per logical core*/
+void levelSetNumberOfThreads(Level* l, const int32_t numberOfThreads);
+
+/** \brief Test if all the moving particles of a level are on the goal
+ * \param l : level to test
+ * \return true if the level contains moving particles and all of them are on the goal*/
+bool levelIsFinished(const Level* l);
+
+/** \brief Prepare the force solver of a level for the current particle positions : copy them in xPrevious and yPrevious,
+ * rebuild the quadtree in EForceSolver_BARNES_HUT mode,
+ * gather the moving particles and rasterize the static field if the non moving particles changed since it was rasterized in EForceSolver_STATIC_FIELD mode.
+ * Called by levelStep() at the beginning of each step. Call it before getAcceleration() if particles were moved outside levelStep()
+ * \param l : level to update*/
+void levelUpdateForceSolver(Level* l);
+
+/** \brief Measure the error of the force solver of a level against the direct sum, on all the moving particles of the level.
+ * The error of a particle is the norm of the force difference divided by the norm of the direct force
+ * \param l : level to measure, with its current force solver parameters
+ * \param rmsError : output parameter, root mean square of the relative errors. Can be NULL
+ * \param maxError : output parameter, maximum relative error. Can be NULL*/
+void levelForceError(Level* l, double* rmsError, double* maxError);
+
+/** \brief Get the x and y acceleration of a particle according to the other particles present in the level,
+ * with the force solver of the level
+ * \param l : level containing the particle
+ * \param p : index of the particle to get the acceleration
+ * \param ax : pointer to output parameter x acceleration
+ * \param ay : pointer to output parameter y acceleration*/
+void getAcceleration(const Level* l, const int32_t p, double* ax, double* ay);
+
+/** \brief Test for a particle passed in parameter collisions with walls, goal and the limits the the playable area.
+ * If a particle touch a limit, set it's coordinate and speed appropriately.
+ * \param l : level containing the particle
+ * \param p : index of the particle to test*/
+void collisions(Level* l, const int32_t p);
+
+/** \brief Test if a particle is within the limits of the goal.
+ * If a particle is on the goal, set the EParticleFlag_GOAL flag of this particle and iterate the number of particles on goal
+ * \param l : level containing the particle
+ * \param p : index of the particle to test
+ * \return true if the particle just arrived on the goal*/
+bool onGoal(Level* l, const int32_t p);
+
+/** \brief Test if the position passed as input parameter is on a particle.
+ * The particle array is browsed in reverse, in order to select the last particle of the array if two particles are overlaped.
+ * The particle hitbox is a circle defined by the particle radius of the level
+ * \param l : level to test
+ * \param x : x cordinate
+ * \param y : y coordinate
+ * \return index of the particle which the input position is on. Return -1 if the position is not on a particle*/
+int32_t levelParticleAt(const Level* l, const int x, const int y);
+
+/** \brief Test if the position passed as input parameter is on a wall.
+ * \param l : level to test
+ * \param x : x coordinate
+ * \param y : y coordinate
+ * \return handle of the wall which the input position is on. Return gNULL_HANDLE if the position is not on a wall*/
+Handle levelWallAt(const Level* l, const int x, const int y);
+
+/** \brief Test if the position passed as input parameter is on the goal.
+ * \param l : level to test
+ * \param x : x coordinate
+ * \param y : y coordinate
+ * \return true if the position is on the goal*/
+bool levelGoalAt(const Level* l, const int x, const int y);
+
+/** \brief Read a level file, text or binary (see levelFileOpen()). Load in the level all the particles, walls and goal of the file.
+ * The level is freed before loading, unless the file can't be read
+ * \param l : level to fill
+ * \param filename : name of the level file
+ * \param modifiable : if true, all the particles are created as modifiable
+ * \param highScores : output parameter, the three high scores of the level. Can be NULL
+ * \return true if the file was read. False if it can't be read, or if the allocation of its content failed : the level is then empty*/
+bool levelLoad(Level* l, const char* filename, bool modifiable, int32_t highScores[3]);
+
+/** \brief Write a level in a level file. Moving particles are saved at their initial position.
+ * \param l : level to save
+ * \param filename : name of the level file
+ * \param saveModifiableParticles : if false, the modifiable non moving particles (the ones created by the player) are not saved
+ * \param highScores : the three high scores to save
+ * \param format : format of the file written
+ * \return true if the file was written*/
+bool levelSave(const Level* l, const char* filename, bool saveModifiableParticles, const int32_t highScores[3], const ELevelFormat format);
+
+/** \brief Clamp the abolute value of a double passed by a pointer by a double limit
+ * \param value : pointer to value to clamp
+ * \param limit : limit of the clamp*/
+void clamp(double* value, const double limit);
+
+/** \brief return the distance between two particles passed as input parameters
+ * \param l : level containing the particles
+ * \param p1 : index of the first particle
+ * \param p2 : index of the second particle
+ * \return : distance between the two particles*/
+double getDistance(const Level* l, const int32_t p1, const int32_t p2);
+
+#endif
@@ -0,0 +1,40 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include "levelfile.h"
+
+
+/*----- MAIN -----*/
+/** \brief Convert a level file between the text and the binary formats. The input format is read from the file,
+ * the output format is given by the extension of the output file : gLEVEL_BINARY_EXTENSION for binary, anything else for text.
+ * Usage : chargelevel input output*/
+int main(int argc, char* argv[])
+{
+	LevelFile f;
+
+	if (argc != 3)
+	{
+		printf("Usage : %s input output \n", argv[0]);
+		printf("Convert a level file. The output is binary if its name ends with %s, text otherwise \n", gLEVEL_BINARY_EXTENSION);
+		return EXIT_FAILURE;
+	}
+
+	if (!levelFileOpen(&f, argv[1]))
+	{
+		printf("ERROR: Can't read %s \n", argv[1]);
+		return EXIT_FAILURE;
+	}
+
+	const ELevelFormat format = levelFileFormat(argv[2]);
+	const bool written = levelFileWrite(&f, argv[2], format);
+
+	if (written)
+	{
+		printf("%s : %d moving particles, %d non moving particles, %d walls, written in %s format \n", argv[2],
+		       f.header->numberOfMovingParticles, f.header->numberOfNonMovingParticles, f.header->numberOfWalls,
+		       format == ELevelFormat_BINARY ? "binary" : "text");
+	}
+	else printf("ERROR: Can't write %s \n", argv[2]);
+
+	levelFileClose(&f);
+	return written ? EXIT_SUCCESS : EXIT_FAILURE;
+}
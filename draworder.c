@@ -0,0 +1,104 @@
+#include <stdlib.h>
+#include "draworder.h"
+
+
+/*----- INTERNAL FUNCTIONS -----*/
+/** \brief Level whose particles are sorted by qsort(), which gives no context to its comparison function*/
+static const Level* gSortedLevel = NULL;
+
+/** \brief Comparison function of qsort() for the drawing order of gSortedLevel
+ * \param a : pointer to the index of the first particle
+ * \param b : pointer to the index of the second particle
+ * \return negative if the first particle is drawn before the second one, positive if it is drawn after, 0 if they are the same particle*/
+static int compareDrawOrder(const void* a, const void* b)
+{
+	const int32_t p1 = *(const int32_t*)a, p2 = *(const int32_t*)b;
+
+	if (p1 == p2) return 0;
+	return drawOrderAfter(gSortedLevel, p1, p2) ? 1 : -1;
+}
+
+
+/*----- DRAWING ORDER FUNCTIONS -----*/
+void drawOrderInit(DrawOrder* d)
+{
+	d->order = NULL;
+	d->numberOfParticles = 0;
+	d->capacity = 0;
+}
+
+bool drawOrderUpdate(DrawOrder* d, const Level* l)
+{
+	int32_t i, j;
+	const int32_t n = l->numberOfParticle;
+
+	if (n > d->capacity)
+	{
+		const int32_t capacity = n > d->capacity * 2 ? n : d->capacity * 2;
+		int32_t* order = (int32_t*)realloc(d->order, capacity * sizeof(int32_t));
+		if (!order)
+		{
+			d->numberOfParticles = 0;
+			return false;
+		}
+		d->order = order;
+		d->capacity = capacity;
+	}
+
+	/*Particles created or destroyed : the indices changed, the order is built again*/
+	if (n != d->numberOfParticles)
+	{
+		for (i = 0; i < n; ++i) d->order[i] = i;
+		gSortedLevel = l;
+		qsort(d->order, n, sizeof(int32_t), compareDrawOrder);
+		d->numberOfParticles = n;
+		return true;
+	}
+
+	/*The particles only moved since the last update : few of them changed of place*/
+	for (i = 1; i < n; ++i)
+	{
+		const int32_t p = d->order[i];
+
+		for (j = i; j > 0 && drawOrderAfter(l, d->order[j - 1], p); --j) d->order[j] = d->order[j - 1];
+		d->order[j] = p;
+	}
+	return true;
+}
+
+bool drawOrderAfter(const Level* l, const int32_t p1, const int32_t p2)
+{
+	const bool moving1 = (l->particles.flags[p1] & EParticleFlag_MOVING) != 0;
+	const bool moving2 = (l->particles.flags[p2] & EParticleFlag_MOVING) != 0;
+	const Real* yCoord = l->particles.yCoord;
+
+	if (moving1 != moving2) return moving1;
+	if (yCoord[p1] != yCoord[p2]) return yCoord[p1] > yCoord[p2];
+	return p1 > p2;
+}
+
+int32_t drawOrderParticleAt(const DrawOrder* d, const Level* l, const int x, const int y)
+{
+	int32_t i;
+	const int r = l->particleRadius;
+
+	/*Particles created or destroyed since the last update : the drawing order is out of date*/
+	if (d->numberOfParticles != l->numberOfParticle) return levelParticleAt(l, x, y);
+
+	/*The particle drawn on top is picked first*/
+	for (i = d->numberOfParticles - 1; i >= 0; --i)
+	{
+		const int32_t p = d->order[i];
+		const int dx = (int)l->particles.xCoord[p] - x;
+		const int dy = (int)l->particles.yCoord[p] - y;
+
+		if (dx * dx + dy * dy < r * r) return p;
+	}
+	return -1;
+}
+
+void drawOrderFree(DrawOrder* d)
+{
+	free(d->order);
+	drawOrderInit(d);
+}
@@ -0,0 +1,57 @@
+#ifndef DRAWORDER_H
+#define DRAWORDER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "chargecore.h"
+
+
+/*----- STRUCTURES -----*/
+/** \brief Structure of the drawing order of the particles of a level : greater y coordinates are drawn on top of smaller ones,
+ * and the moving particles on top of the non moving ones. The particle array itself is not modified
+ * \param order : indices of the particles, from the one drawn first to the one drawn on top
+ * \param numberOfParticles : number of particles in order. Set it to 0 to get the order built again by the next drawOrderUpdate()
+ * \param capacity : number of indices allocated in order*/
+typedef struct DrawOrder
+{
+	int32_t* order;
+	int32_t numberOfParticles;
+	int32_t capacity;
+} DrawOrder;
+
+
+/*----- FUNCTION PROTOTYPES -----*/
+/** \brief Initialize an empty drawing order
+ * \param d : drawing order to initialize*/
+void drawOrderInit(DrawOrder* d);
+
+/** \brief Sort a drawing order for the current positions of the particles of a level.
+ * The order of the last frame is nearly sorted : it is sorted again by insertion, in about O(n).
+ * When particles were created or destroyed, the order is built again and sorted with qsort()
+ * \param d : drawing order
+ * \param l : level containing the particles
+ * \return false if the allocation of the order failed. The order is then empty*/
+bool drawOrderUpdate(DrawOrder* d, const Level* l);
+
+/** \brief Compare two particles in the drawing order
+ * \param l : level containing the particles
+ * \param p1 : index of the first particle
+ * \param p2 : index of the second particle
+ * \return true if p1 is drawn after (on top of) p2*/
+bool drawOrderAfter(const Level* l, const int32_t p1, const int32_t p2);
+
+/** \brief Test if a position is on a particle of a level. The drawing order is browsed in reverse, in order to select
+ * the particle drawn on top if two particles are overlaped. If particles were created or destroyed since the last drawOrderUpdate(),
+ * levelParticleAt() is used instead. The particle hitbox is a circle defined by the particle radius of the level
+ * \param d : drawing order of the level
+ * \param l : level to test
+ * \param x : x cordinate
+ * \param y : y coordinate
+ * \return index of the particle which the input position is on. Return -1 if the position is not on a particle*/
+int32_t drawOrderParticleAt(const DrawOrder* d, const Level* l, const int x, const int y);
+
+/** \brief Free the indices of a drawing order. The order can be updated again afterwards
+ * \param d : drawing order to free*/
+void drawOrderFree(DrawOrder* d);
+
+#endif
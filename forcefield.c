@@ -0,0 +1,147 @@
+#include <stdlib.h>
+#include <math.h>
+#include "chargecore.h"
+#include "forcefield.h"
+
+
+/*----- INTERNAL FUNCTIONS -----*/
+/** \brief Parameters shared by the tasks of forceFieldBuild()
+ * \param f : force field being built
+ * \param x, y, charge : particles creating the field
+ * \param n : number of particles
+ * \param quadtree : quadtree of the particles, used if useQuadtree is true
+ * \param useQuadtree : true if the samples are computed with the quadtree instead of a direct sum
+ * \param openingAngle : opening angle of the quadtree*/
+typedef struct BuildContext
+{
+	ForceField* f;
+	const Real* x;
+	const Real* y;
+	const int32_t* charge;
+	int32_t n;
+	const Quadtree* quadtree;
+	bool useQuadtree;
+	double openingAngle;
+} BuildContext;
+
+/** \brief Task of forceFieldBuild() : sample the field of a unit charge at each node of a row, with the same formula as getAcceleration()
+ * \param context : pointer to the BuildContext of the field
+ * \param task : index of the row*/
+static void buildRowTask(void* context, const int32_t task)
+{
+	const BuildContext* b = (const BuildContext*)context;
+	ForceField* f = b->f;
+	const double ySample = task * f->cellSize;
+	int32_t i;
+
+	for (i = 0; i < f->width; ++i)
+	{
+		const double xSample = i * f->cellSize;
+		double ex, ey;
+
+		if (b->useQuadtree) quadtreeForce(b->quadtree, -1, xSample, ySample, 1, b->openingAngle, &ex, &ey);
+		else forceKernelField(b->x, b->y, b->charge, b->n, xSample, ySample, &ex, &ey);
+
+		f->xField[task * f->width + i] = (float)ex;
+		f->yField[task * f->width + i] = (float)ey;
+	}
+}
+
+
+/*----- FORCE FIELD FUNCTIONS -----*/
+bool forceFieldBuild(ForceField* f, const Real* x, const Real* y, const int32_t* charge, const int32_t n, const int areaWidth,
+                     const int areaHeight, const double cellSize, const double openingAngle, ThreadPool* pool)
+{
+	Quadtree quadtree = {0};
+	const bool useQuadtree = n > gFORCE_FIELD_QUADTREE_THRESHOLD;
+	BuildContext build;
+
+	f->cellSize = cellSize;
+	f->width = (int32_t)ceil(areaWidth / cellSize) + 1;
+	f->height = (int32_t)ceil(areaHeight / cellSize) + 1;
+
+	if (f->width * f->height > f->capacity)
+	{
+		float* xField = (float*)realloc(f->xField, f->width * f->height * sizeof(float));
+		if (xField) f->xField = xField;
+		float* yField = (float*)realloc(f->yField, f->width * f->height * sizeof(float));
+		if (yField) f->yField = yField;
+
+		if (!xField || !yField)
+		{
+			f->width = 0;
+			f->height = 0;
+			return false;
+		}
+		f->capacity = f->width * f->height;
+	}
+
+	if (useQuadtree && !quadtreeBuild(&quadtree, x, y, charge, n))
+	{
+		quadtreeFree(&quadtree);
+		f->width = 0;
+		f->height = 0;
+		return false;
+	}
+
+	/*Sample the rows in parallel : each task only writes its own row*/
+	build.f = f;
+	build.x = x;
+	build.y = y;
+	build.charge = charge;
+	build.n = n;
+	build.quadtree = &quadtree;
+	build.useQuadtree = useQuadtree;
+	build.openingAngle = openingAngle;
+	threadPoolRun(pool, f->height, buildRowTask, &build);
+
+	quadtreeFree(&quadtree);
+	return true;
+}
+
+void forceFieldSample(const ForceField* f, const double x, const double y, double* ex, double* ey)
+{
+	double u = x / f->cellSize;
+	double v = y / f->cellSize;
+	double w00, w10, w01, w11;
+	int32_t i, j, k;
+
+	if (f->width < 2 || f->height < 2)
+	{
+		*ex = 0;
+		*ey = 0;
+		return;
+	}
+
+	/*Clamp the position to the grid*/
+	u = fmin(fmax(u, 0), f->width - 1);
+	v = fmin(fmax(v, 0), f->height - 1);
+	i = (int32_t)u;
+	j = (int32_t)v;
+	if (i > f->width - 2) i = f->width - 2;
+	if (j > f->height - 2) j = f->height - 2;
+	u -= i;
+	v -= j;
+
+	/*Bilinear interpolation between the four samples around the position*/
+	k = j * f->width + i;
+	w00 = (1 - u) * (1 - v);
+	w10 = u * (1 - v);
+	w01 = (1 - u) * v;
+	w11 = u * v;
+
+	*ex = w00 * f->xField[k] + w10 * f->xField[k + 1] + w01 * f->xField[k + f->width] + w11 * f->xField[k + f->width + 1];
+	*ey = w00 * f->yField[k] + w10 * f->yField[k + 1] + w01 * f->yField[k + f->width] + w11 * f->yField[k + f->width + 1];
+}
+
+void forceFieldFree(ForceField* f)
+{
+	free(f->xField);
+	free(f->yField);
+
+	f->xField = NULL;
+	f->yField = NULL;
+	f->width = 0;
+	f->height = 0;
+	f->capacity = 0;
+}
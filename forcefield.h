@@ -0,0 +1,66 @@
+#ifndef FORCEFIELD_H
+#define FORCEFIELD_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "forcekernel.h"
+#include "threadpool.h"
+
+
+/*----- CONSTANTS -----*/
+/** \brief Default distance between two samples of a force field, in pixels*/
+#define gFORCE_FIELD_CELL_SIZE 1.0
+
+/** \brief Number of source particles above which a force field is rasterized with a quadtree instead of a direct sum*/
+#define gFORCE_FIELD_QUADTREE_THRESHOLD 256
+
+
+/*----- STRUCTURES -----*/
+/** \brief Structure of a force field : electric field of a set of charges, sampled on a regular grid.
+ * The force applied on a charge c at a sample is c * (xField, yField). Between samples, the field is interpolated bilinearly
+ * \param xField : x component of the field at each sample, row by row
+ * \param yField : y component of the field at each sample, row by row
+ * \param width : number of samples on a row
+ * \param height : number of rows
+ * \param cellSize : distance between two samples, in pixels
+ * \param capacity : number of samples allocated*/
+typedef struct ForceField
+{
+	float* xField;
+	float* yField;
+	int32_t width;
+	int32_t height;
+	double cellSize;
+	int32_t capacity;
+} ForceField;
+
+
+/*----- FUNCTION PROTOTYPES -----*/
+/** \brief Rasterize the field of a set of particles on the area [0, areaWidth] x [0, areaHeight]. Each row of samples is a task of the thread pool
+ * \param f : force field to build
+ * \param x : x coordinates of the particles creating the field
+ * \param y : y coordinates of the particles creating the field
+ * \param charge : charges of the particles creating the field
+ * \param n : number of particles
+ * \param areaWidth : width of the area to cover
+ * \param areaHeight : height of the area to cover
+ * \param cellSize : distance between two samples, in pixels
+ * \param openingAngle : opening angle of the quadtree used when there are more than gFORCE_FIELD_QUADTREE_THRESHOLD particles
+ * \param pool : threads sampling the rows. If NULL, the rows are sampled by the calling thread
+ * \return false if an allocation failed*/
+bool forceFieldBuild(ForceField* f, const Real* x, const Real* y, const int32_t* charge, const int32_t n, const int areaWidth,
+                     const int areaHeight, const double cellSize, const double openingAngle, ThreadPool* pool);
+
+/** \brief Get the field at a position with a bilinear interpolation. Positions outside the area get the field of the nearest border
+ * \param f : force field built with forceFieldBuild()
+ * \param x : x coordinate
+ * \param y : y coordinate
+ * \param ex : pointer to output parameter x field
+ * \param ey : pointer to output parameter y field*/
+void forceFieldSample(const ForceField* f, const double x, const double y, double* ex, double* ey);
+
+/** \brief Free the samples of a force field. The force field can be built again afterwards
+ * \param f : force field to free*/
+void forceFieldFree(ForceField* f);
+
+#endif
@@ -0,0 +1,310 @@
+#include <math.h>
+#include "chargecore.h"
+#include "forcekernel.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define FORCE_KERNEL_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+/*Every kernel sums the charges in gKERNEL_LANES partial sums, as many as the widest SIMD register holds*/
+#ifdef CHARGECORE_FLOAT32
+#define gKERNEL_LANES 8
+#define realSqrt sqrtf
+#else
+#define gKERNEL_LANES 4
+#define realSqrt sqrt
+#endif
+
+/*GCC and Clang only emit the SIMD instructions in functions explicitly compiled for them. MSVC always emits them*/
+#if defined(__GNUC__) || defined(__clang__)
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_SSE2
+#define TARGET_AVX2
+#endif
+
+
+/*----- GLOBAL VARIABLES -----*/
+/** \brief Instruction set used by forceKernelField()*/
+static EForceKernel gForceKernel = EForceKernel_SCALAR;
+
+/** \brief true once gForceKernel has been set, by the CPU detection or by forceKernelUse()*/
+static bool gForceKernelSelected = false;
+
+
+/*----- INTERNAL FUNCTIONS -----*/
+/** \brief Test if the CPU and the operating system support an instruction set
+ * \param kernel : instruction set to test
+ * \return true if the instruction set can be used*/
+static bool isSupported(const EForceKernel kernel)
+{
+	if (kernel == EForceKernel_SCALAR) return true;
+
+#if defined(FORCE_KERNEL_X86) && (defined(__GNUC__) || defined(__clang__))
+	__builtin_cpu_init();
+	if (kernel == EForceKernel_SSE2) return __builtin_cpu_supports("sse2");
+	if (kernel == EForceKernel_AVX2) return __builtin_cpu_supports("avx2");
+#elif defined(FORCE_KERNEL_X86) && defined(_MSC_VER)
+	int info[4];
+
+	__cpuid(info, 1);
+	if (kernel == EForceKernel_SSE2) return (info[3] & (1 << 26)) != 0;
+
+	/*AVX2 needs the OS to save the 256 bits registers (OSXSAVE, AVX and XCR0) on top of the CPU support*/
+	if (kernel == EForceKernel_AVX2)
+	{
+		if (!(info[2] & (1 << 27)) || !(info[2] & (1 << 28)) || (_xgetbv(0) & 6) != 6) return false;
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+	}
+#endif
+	return false;
+}
+
+/** \brief Add the field of one charge to a partial sum, with the operations of the SIMD kernels in the same order and precision
+ * \param x : x coordinate of the charge
+ * \param y : y coordinate of the charge
+ * \param charge : charge
+ * \param px : x coordinate of the position
+ * \param py : y coordinate of the position
+ * \param sumX : partial sum of the x field
+ * \param sumY : partial sum of the y field*/
+static void addField(const Real x, const Real y, const int32_t charge, const Real px, const Real py, Real* sumX, Real* sumY)
+{
+	const Real minimumDistance2 = (Real)(gMIN_DISTANCE * gMIN_DISTANCE);
+	const Real dx = x - px;
+	const Real dy = y - py;
+	Real d2 = dx * dx + dy * dy;
+	d2 = d2 > minimumDistance2 ? d2 : minimumDistance2;
+	const Real e = (Real)charge / (d2 * realSqrt(d2));
+
+	*sumX = *sumX - e * dx;
+	*sumY = *sumY - e * dy;
+}
+
+/** \brief End of every kernel : add the charges [begin, n) left after the last block to their lanes, then sum the lanes by pairs.
+ * Lane k holds the charges k, k + gKERNEL_LANES, k + 2 * gKERNEL_LANES... in this order, so the result doesn't depend on the kernel
+ * \param lanesX : partial sums of the x field, one per lane
+ * \param lanesY : partial sums of the y field, one per lane
+ * \param begin : first charge not summed yet, a multiple of gKERNEL_LANES. See forceKernelField() for the other parameters*/
+static void reduceLanes(Real* lanesX, Real* lanesY, const Real* x, const Real* y, const int32_t* charge, int32_t begin, const int32_t n,
+                        const double px, const double py, double* ex, double* ey)
+{
+	double sumX[gKERNEL_LANES], sumY[gKERNEL_LANES];
+	int32_t j, width;
+
+	for (; begin < n; ++begin) addField(x[begin], y[begin], charge[begin], (Real)px, (Real)py, &lanesX[begin % gKERNEL_LANES], &lanesY[begin % gKERNEL_LANES]);
+
+	for (j = 0; j < gKERNEL_LANES; ++j)
+	{
+		sumX[j] = lanesX[j];
+		sumY[j] = lanesY[j];
+	}
+	for (width = gKERNEL_LANES / 2; width > 0; width /= 2)
+	{
+		for (j = 0; j < width; ++j)
+		{
+			sumX[j] = sumX[2 * j] + sumX[2 * j + 1];
+			sumY[j] = sumY[2 * j] + sumY[2 * j + 1];
+		}
+	}
+
+	*ex = sumX[0];
+	*ey = sumY[0];
+}
+
+/** \brief Sum the field of a set of charges at a position, one charge at a time in gKERNEL_LANES partial sums. See forceKernelField()*/
+static void fieldScalar(const Real* x, const Real* y, const int32_t* charge, const int32_t n, const double px, const double py,
+                        double* ex, double* ey)
+{
+	Real lanesX[gKERNEL_LANES] = {0}, lanesY[gKERNEL_LANES] = {0};
+	int32_t i, j;
+
+	for (i = 0; i + gKERNEL_LANES <= n; i += gKERNEL_LANES)
+	{
+		for (j = 0; j < gKERNEL_LANES; ++j) addField(x[i + j], y[i + j], charge[i + j], (Real)px, (Real)py, &lanesX[j], &lanesY[j]);
+	}
+
+	reduceLanes(lanesX, lanesY, x, y, charge, i, n, px, py, ex, ey);
+}
+
+#ifdef FORCE_KERNEL_X86
+#ifdef CHARGECORE_FLOAT32
+/** \brief Sum the field of a set of charges at a position, 4 floats per instruction, two registers per block. See forceKernelField()*/
+TARGET_SSE2 static void fieldSse2(const Real* x, const Real* y, const int32_t* charge, const int32_t n,
+                                  const double px, const double py, double* ex, double* ey)
+{
+	const __m128 vpx = _mm_set1_ps((float)px);
+	const __m128 vpy = _mm_set1_ps((float)py);
+	const __m128 minimumDistance2 = _mm_set1_ps((float)(gMIN_DISTANCE * gMIN_DISTANCE));
+	__m128 sumX[2] = {_mm_setzero_ps(), _mm_setzero_ps()};
+	__m128 sumY[2] = {_mm_setzero_ps(), _mm_setzero_ps()};
+	float lanesX[gKERNEL_LANES], lanesY[gKERNEL_LANES];
+	int32_t i, k;
+
+	for (i = 0; i + gKERNEL_LANES <= n; i += gKERNEL_LANES)
+	{
+		for (k = 0; k < 2; ++k)
+		{
+			const __m128 dx = _mm_sub_ps(_mm_loadu_ps(x + i + 4 * k), vpx);
+			const __m128 dy = _mm_sub_ps(_mm_loadu_ps(y + i + 4 * k), vpy);
+			const __m128 c = _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i*)(charge + i + 4 * k)));
+			const __m128 d2 = _mm_max_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), minimumDistance2);
+			const __m128 e = _mm_div_ps(c, _mm_mul_ps(d2, _mm_sqrt_ps(d2)));
+
+			sumX[k] = _mm_sub_ps(sumX[k], _mm_mul_ps(e, dx));
+			sumY[k] = _mm_sub_ps(sumY[k], _mm_mul_ps(e, dy));
+		}
+	}
+
+	for (k = 0; k < 2; ++k)
+	{
+		_mm_storeu_ps(lanesX + 4 * k, sumX[k]);
+		_mm_storeu_ps(lanesY + 4 * k, sumY[k]);
+	}
+	reduceLanes(lanesX, lanesY, x, y, charge, i, n, px, py, ex, ey);
+}
+
+/** \brief Sum the field of a set of charges at a position, 8 floats per instruction. See forceKernelField()*/
+TARGET_AVX2 static void fieldAvx2(const Real* x, const Real* y, const int32_t* charge, const int32_t n,
+                                  const double px, const double py, double* ex, double* ey)
+{
+	const __m256 vpx = _mm256_set1_ps((float)px);
+	const __m256 vpy = _mm256_set1_ps((float)py);
+	const __m256 minimumDistance2 = _mm256_set1_ps((float)(gMIN_DISTANCE * gMIN_DISTANCE));
+	__m256 sumX = _mm256_setzero_ps();
+	__m256 sumY = _mm256_setzero_ps();
+	float lanesX[gKERNEL_LANES], lanesY[gKERNEL_LANES];
+	int32_t i;
+
+	for (i = 0; i + gKERNEL_LANES <= n; i += gKERNEL_LANES)
+	{
+		const __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(x + i), vpx);
+		const __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(y + i), vpy);
+		const __m256 c = _mm256_cvtepi32_ps(_mm256_loadu_si256((const __m256i*)(charge + i)));
+		const __m256 d2 = _mm256_max_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), minimumDistance2);
+		const __m256 e = _mm256_div_ps(c, _mm256_mul_ps(d2, _mm256_sqrt_ps(d2)));
+
+		sumX = _mm256_sub_ps(sumX, _mm256_mul_ps(e, dx));
+		sumY = _mm256_sub_ps(sumY, _mm256_mul_ps(e, dy));
+	}
+
+	_mm256_storeu_ps(lanesX, sumX);
+	_mm256_storeu_ps(lanesY, sumY);
+	reduceLanes(lanesX, lanesY, x, y, charge, i, n, px, py, ex, ey);
+}
+#else
+/** \brief Sum the field of a set of charges at a position, 2 doubles per instruction, two registers per block. See forceKernelField()*/
+TARGET_SSE2 static void fieldSse2(const Real* x, const Real* y, const int32_t* charge, const int32_t n,
+                                  const double px, const double py, double* ex, double* ey)
+{
+	const __m128d vpx = _mm_set1_pd(px);
+	const __m128d vpy = _mm_set1_pd(py);
+	const __m128d minimumDistance2 = _mm_set1_pd(gMIN_DISTANCE * gMIN_DISTANCE);
+	__m128d sumX[2] = {_mm_setzero_pd(), _mm_setzero_pd()};
+	__m128d sumY[2] = {_mm_setzero_pd(), _mm_setzero_pd()};
+	double lanesX[gKERNEL_LANES], lanesY[gKERNEL_LANES];
+	int32_t i, k;
+
+	for (i = 0; i + gKERNEL_LANES <= n; i += gKERNEL_LANES)
+	{
+		for (k = 0; k < 2; ++k)
+		{
+			const __m128d dx = _mm_sub_pd(_mm_loadu_pd(x + i + 2 * k), vpx);
+			const __m128d dy = _mm_sub_pd(_mm_loadu_pd(y + i + 2 * k), vpy);
+			const __m128d c = _mm_cvtepi32_pd(_mm_loadl_epi64((const __m128i*)(charge + i + 2 * k)));
+			const __m128d d2 = _mm_max_pd(_mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy)), minimumDistance2);
+			const __m128d e = _mm_div_pd(c, _mm_mul_pd(d2, _mm_sqrt_pd(d2)));
+
+			sumX[k] = _mm_sub_pd(sumX[k], _mm_mul_pd(e, dx));
+			sumY[k] = _mm_sub_pd(sumY[k], _mm_mul_pd(e, dy));
+		}
+	}
+
+	for (k = 0; k < 2; ++k)
+	{
+		_mm_storeu_pd(lanesX + 2 * k, sumX[k]);
+		_mm_storeu_pd(lanesY + 2 * k, sumY[k]);
+	}
+	reduceLanes(lanesX, lanesY, x, y, charge, i, n, px, py, ex, ey);
+}
+
+/** \brief Sum the field of a set of charges at a position, 4 doubles per instruction. See forceKernelField()*/
+TARGET_AVX2 static void fieldAvx2(const Real* x, const Real* y, const int32_t* charge, const int32_t n,
+                                  const double px, const double py, double* ex, double* ey)
+{
+	const __m256d vpx = _mm256_set1_pd(px);
+	const __m256d vpy = _mm256_set1_pd(py);
+	const __m256d minimumDistance2 = _mm256_set1_pd(gMIN_DISTANCE * gMIN_DISTANCE);
+	__m256d sumX = _mm256_setzero_pd();
+	__m256d sumY = _mm256_setzero_pd();
+	double lanesX[gKERNEL_LANES], lanesY[gKERNEL_LANES];
+	int32_t i;
+
+	for (i = 0; i + gKERNEL_LANES <= n; i += gKERNEL_LANES)
+	{
+		const __m256d dx = _mm256_sub_pd(_mm256_loadu_pd(x + i), vpx);
+		const __m256d dy = _mm256_sub_pd(_mm256_loadu_pd(y + i), vpy);
+		const __m256d c = _mm256_cvtepi32_pd(_mm_loadu_si128((const __m128i*)(charge + i)));
+		const __m256d d2 = _mm256_max_pd(_mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy)), minimumDistance2);
+		const __m256d e = _mm256_div_pd(c, _mm256_mul_pd(d2, _mm256_sqrt_pd(d2)));
+
+		sumX = _mm256_sub_pd(sumX, _mm256_mul_pd(e, dx));
+		sumY = _mm256_sub_pd(sumY, _mm256_mul_pd(e, dy));
+	}
+
+	_mm256_storeu_pd(lanesX, sumX);
+	_mm256_storeu_pd(lanesY, sumY);
+	reduceLanes(lanesX, lanesY, x, y, charge, i, n, px, py, ex, ey);
+}
+#endif
+#endif
+
+
+/*----- FORCE KERNEL FUNCTIONS -----*/
+void forceKernelField(const Real* x, const Real* y, const int32_t* charge, const int32_t n, const double px, const double py,
+                      double* ex, double* ey)
+{
+	switch (forceKernelInstructionSet())
+	{
+#ifdef FORCE_KERNEL_X86
+	case EForceKernel_AVX2:
+		fieldAvx2(x, y, charge, n, px, py, ex, ey);
+		break;
+
+	case EForceKernel_SSE2:
+		fieldSse2(x, y, charge, n, px, py, ex, ey);
+		break;
+#endif
+
+	default:
+		fieldScalar(x, y, charge, n, px, py, ex, ey);
+	}
+}
+
+EForceKernel forceKernelInstructionSet(void)
+{
+	if (!gForceKernelSelected)
+	{
+		if (isSupported(EForceKernel_AVX2)) gForceKernel = EForceKernel_AVX2;
+		else if (isSupported(EForceKernel_SSE2)) gForceKernel = EForceKernel_SSE2;
+		else gForceKernel = EForceKernel_SCALAR;
+
+		gForceKernelSelected = true;
+	}
+	return gForceKernel;
+}
+
+bool forceKernelUse(const EForceKernel kernel)
+{
+	if (!isSupported(kernel)) return false;
+
+	gForceKernel = kernel;
+	gForceKernelSelected = true;
+	return true;
+}
@@ -0,0 +1,55 @@
+#ifndef FORCEKERNEL_H
+#define FORCEKERNEL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+/*----- TYPES -----*/
+/** \brief Floating point type of the particle coordinates and speeds. Define CHARGECORE_FLOAT32 (CMake option of the same name)
+ * to store them in single precision : the SIMD force kernel then processes twice as many particles per instruction*/
+#ifdef CHARGECORE_FLOAT32
+typedef float Real;
+#else
+typedef double Real;
+#endif
+
+
+/*----- ENUMERATIONS -----*/
+/** \brief Instruction sets the force kernel can be run with*/
+typedef enum EForceKernel
+{
+	EForceKernel_SCALAR, //Plain C, available everywhere
+	EForceKernel_SSE2, //2 doubles or 4 floats per instruction
+	EForceKernel_AVX2 //4 doubles or 8 floats per instruction
+} EForceKernel;
+
+
+/*----- FUNCTION PROTOTYPES -----*/
+/** \brief Sum the field of a set of charges at a position : e = sum of -c * (xOther - x, yOther - y) / d^3,
+ * with d the distance clamped to gMIN_DISTANCE. The force applied on a charge c at the position is c * e.
+ * A charge exactly at the position has no effect, so the particle the field is computed for doesn't have to be skipped.
+ * All the instruction sets give the same bits : the charges are summed in 4 partial sums (8 with CHARGECORE_FLOAT32), charge i in the sum i modulo 4 (8),
+ * in the precision of Real and without fused multiply-add (ChargeCore is built with -ffp-contract=off), then the partial sums are added by pairs.
+ * A level therefore gives the same trajectories on every CPU. The first call selects the best instruction set supported by the CPU, see forceKernelInstructionSet()
+ * \param x : x coordinates of the charges
+ * \param y : y coordinates of the charges
+ * \param charge : charges
+ * \param n : number of charges
+ * \param px : x coordinate of the position
+ * \param py : y coordinate of the position
+ * \param ex : pointer to output parameter x field
+ * \param ey : pointer to output parameter y field*/
+void forceKernelField(const Real* x, const Real* y, const int32_t* charge, const int32_t n, const double px, const double py,
+                      double* ex, double* ey);
+
+/** \brief Get the instruction set used by forceKernelField(). Detected on the first call
+ * \return the best instruction set supported by the CPU, unless another one was forced by forceKernelUse()*/
+EForceKernel forceKernelInstructionSet(void);
+
+/** \brief Force the instruction set used by forceKernelField(), to compare them
+ * \param kernel : instruction set to use
+ * \return false if the CPU doesn't support this instruction set. The instruction set is then unchanged*/
+bool forceKernelUse(const EForceKernel kernel);
+
+#endif
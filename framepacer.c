@@ -0,0 +1,87 @@
+#include <string.h>
+#include "framepacer.h"
+#include "timer.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+
+/*----- CONSTANTS -----*/
+/** \brief Smallest and greatest sleep margins of a frame pacer, in nanoseconds*/
+#define gMIN_SLEEP_MARGIN 200000u
+#define gMAX_SLEEP_MARGIN 20000000u
+
+
+/*----- INTERNAL FUNCTIONS -----*/
+/** \brief Give the processor back to the system for a duration. The system may wake the thread up later
+ * \param nanoseconds : duration to sleep*/
+static void sleepFor(const uint64_t nanoseconds)
+{
+#ifdef _WIN32
+	/*Sleep() counts in milliseconds : the part below is left to the spin*/
+	if (nanoseconds >= 1000000u) Sleep((DWORD)(nanoseconds / 1000000u));
+#else
+	struct timespec duration;
+
+	duration.tv_sec = (time_t)(nanoseconds / 1000000000u);
+	duration.tv_nsec = (long)(nanoseconds % 1000000000u);
+	nanosleep(&duration, NULL);
+#endif
+}
+
+
+/*----- FRAME PACER FUNCTIONS -----*/
+void framePacerInit(FramePacer* p, const int32_t framesPerSecond)
+{
+	memset(p, 0, sizeof(FramePacer));
+	p->sleepMargin = gMIN_SLEEP_MARGIN;
+	framePacerSetRate(p, framesPerSecond);
+}
+
+void framePacerSetRate(FramePacer* p, const int32_t framesPerSecond)
+{
+	p->framePeriod = framesPerSecond > 0 ? 1000000000u / (uint64_t)framesPerSecond : 0;
+	p->deadline = timerNanoseconds() + p->framePeriod;
+	histogramInit(&p->frameTimes);
+}
+
+uint64_t framePacerWait(FramePacer* p)
+{
+	uint64_t now = timerNanoseconds();
+
+	if (p->framePeriod > 0)
+	{
+		/*Sleep while the deadline is further than the margin*/
+		while (now < p->deadline && p->deadline - now > p->sleepMargin)
+		{
+			const uint64_t request = p->deadline - now - p->sleepMargin;
+			sleepFor(request);
+
+			const uint64_t slept = timerNanoseconds() - now;
+			now += slept;
+
+			/*The margin jumps to an oversleep greater than it, and decreases slowly toward the smaller ones*/
+			const uint64_t oversleep = slept > request ? slept - request : 0;
+			if (oversleep > p->sleepMargin) p->sleepMargin = oversleep;
+			else p->sleepMargin -= (p->sleepMargin - oversleep) / 16;
+
+			if (p->sleepMargin < gMIN_SLEEP_MARGIN) p->sleepMargin = gMIN_SLEEP_MARGIN;
+			if (p->sleepMargin > gMAX_SLEEP_MARGIN) p->sleepMargin = gMAX_SLEEP_MARGIN;
+		}
+
+		/*Spin until the deadline*/
+		while (now < p->deadline) now = timerNanoseconds();
+
+		/*The next deadline is one period after this one, unless this frame ended too late to keep the cadence*/
+		p->deadline = now - p->deadline < p->framePeriod ? p->deadline + p->framePeriod : now + p->framePeriod;
+	}
+
+	const uint64_t frameTime = p->lastFrameEnd ? now - p->lastFrameEnd : 0;
+	if (p->lastFrameEnd) histogramRecord(&p->frameTimes, frameTime);
+	p->lastFrameEnd = now;
+
+	return frameTime;
+}
@@ -0,0 +1,44 @@
+#ifndef FRAMEPACER_H
+#define FRAMEPACER_H
+
+#include <stdint.h>
+#include "histogram.h"
+
+
+/*----- STRUCTURES -----*/
+/** \brief Structure of a frame pacer : ends each frame at a deadline of a monotonic nanosecond clock, see timerNanoseconds().
+ * The pacer sleeps until a margin before the deadline, then spins until the deadline. The margin follows how late the sleeps of the
+ * system wake up, so that the spin stays short on a fine scheduler and covers the oversleep of a coarse one
+ * \param framePeriod : duration of a frame, in nanoseconds. 0 : uncapped, the frames are not waited
+ * \param deadline : time at which the current frame ends, in nanoseconds
+ * \param lastFrameEnd : time at which the last frame ended, in nanoseconds. 0 before the first frame
+ * \param sleepMargin : time before the deadline at which the pacer stops sleeping and starts spinning, in nanoseconds
+ * \param frameTimes : durations of the frames since the last change of frame rate*/
+typedef struct FramePacer
+{
+	uint64_t framePeriod;
+	uint64_t deadline;
+	uint64_t lastFrameEnd;
+	uint64_t sleepMargin;
+	Histogram frameTimes;
+} FramePacer;
+
+
+/*----- FUNCTION PROTOTYPES -----*/
+/** \brief Initialize a frame pacer
+ * \param p : frame pacer to initialize
+ * \param framesPerSecond : target frame rate. 0 : uncapped*/
+void framePacerInit(FramePacer* p, const int32_t framesPerSecond);
+
+/** \brief Change the target frame rate of a frame pacer. The frame time statistics start again
+ * \param p : frame pacer
+ * \param framesPerSecond : target frame rate. 0 : uncapped*/
+void framePacerSetRate(FramePacer* p, const int32_t framesPerSecond);
+
+/** \brief End a frame : wait for its deadline, then set the deadline of the next frame. A frame later than a whole period
+ * doesn't make the next ones shorter : the deadlines start again from the end of the late frame
+ * \param p : frame pacer
+ * \return duration of the frame, from the end of the last one, in nanoseconds. 0 for the first frame*/
+uint64_t framePacerWait(FramePacer* p);
+
+#endif
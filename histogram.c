@@ -0,0 +1,111 @@
+#include <stdio.h>
+#include <string.h>
+#include "histogram.h"
+
+
+/*----- CONSTANTS -----*/
+/** \brief Length of the bar of the fullest bucket printed by histogramPrint()*/
+#define gHISTOGRAM_BAR_LENGTH 50
+
+
+/*----- INTERNAL FUNCTIONS -----*/
+/** \brief Get the bucket of a duration
+ * \param microseconds : duration in microseconds
+ * \return index of the bucket*/
+static int32_t bucketOf(const uint64_t microseconds)
+{
+	int32_t power = 0;
+
+	if (microseconds < 2 * gHISTOGRAM_SUB_BUCKETS) return (int32_t)microseconds;
+
+	/*Power of two of the duration, then its gHISTOGRAM_SUB_BUCKETS first bits below the highest one*/
+	while (microseconds >> (power + 1)) power++;
+	const int32_t bucket = 2 * gHISTOGRAM_SUB_BUCKETS + (power - gHISTOGRAM_SUB_BUCKET_BITS - 1) * gHISTOGRAM_SUB_BUCKETS
+	                       + (int32_t)((microseconds >> (power - gHISTOGRAM_SUB_BUCKET_BITS)) & (gHISTOGRAM_SUB_BUCKETS - 1));
+
+	return bucket < gHISTOGRAM_BUCKETS ? bucket : gHISTOGRAM_BUCKETS - 1;
+}
+
+/** \brief Get the smallest duration of a bucket
+ * \param bucket : index of the bucket
+ * \return duration in microseconds*/
+static uint64_t bucketStart(const int32_t bucket)
+{
+	if (bucket < 2 * gHISTOGRAM_SUB_BUCKETS) return (uint64_t)bucket;
+
+	const int32_t power = (bucket - 2 * gHISTOGRAM_SUB_BUCKETS) / gHISTOGRAM_SUB_BUCKETS + gHISTOGRAM_SUB_BUCKET_BITS + 1;
+	const uint64_t subBucket = (uint64_t)((bucket - 2 * gHISTOGRAM_SUB_BUCKETS) % gHISTOGRAM_SUB_BUCKETS);
+
+	return (gHISTOGRAM_SUB_BUCKETS + subBucket) << (power - gHISTOGRAM_SUB_BUCKET_BITS);
+}
+
+
+/*----- HISTOGRAM FUNCTIONS -----*/
+void histogramInit(Histogram* h)
+{
+	memset(h, 0, sizeof(Histogram));
+}
+
+void histogramRecord(Histogram* h, const uint64_t nanoseconds)
+{
+	h->buckets[bucketOf(nanoseconds / 1000)]++;
+
+	if (h->count == 0 || nanoseconds < h->min) h->min = nanoseconds;
+	if (nanoseconds > h->max) h->max = nanoseconds;
+	h->count++;
+	h->sum += nanoseconds;
+}
+
+uint64_t histogramPercentile(const Histogram* h, const double percentile)
+{
+	uint64_t seen = 0;
+	int32_t i;
+
+	if (h->count == 0) return 0;
+
+	/*Rank of the percentile, from 1 to count*/
+	uint64_t rank = (uint64_t)(percentile / 100.0 * (double)h->count + 0.5);
+	if (rank < 1) rank = 1;
+	if (rank > h->count) rank = h->count;
+
+	for (i = 0; i < gHISTOGRAM_BUCKETS; ++i)
+	{
+		seen += h->buckets[i];
+		if (seen >= rank)
+		{
+			/*The middle of the bucket, kept within the durations recorded*/
+			uint64_t middle = (bucketStart(i) + (i + 1 < gHISTOGRAM_BUCKETS ? bucketStart(i + 1) : bucketStart(i) + 1)) * 500;
+			if (middle < h->min) middle = h->min;
+			if (middle > h->max) middle = h->max;
+			return middle;
+		}
+	}
+	return h->max;
+}
+
+void histogramPrint(const Histogram* h, const char* title)
+{
+	uint32_t fullest = 0;
+	int32_t i;
+
+	printf("HISTOGRAM : %s, %llu samples \n", title, (unsigned long long)h->count);
+	if (h->count == 0) return;
+
+	printf("  mean %.3f ms, p50 %.3f ms, p95 %.3f ms, p99 %.3f ms, min %.3f ms, max %.3f ms \n", (double)h->sum / h->count * 1e-6,
+	       histogramPercentile(h, 50) * 1e-6, histogramPercentile(h, 95) * 1e-6, histogramPercentile(h, 99) * 1e-6,
+	       h->min * 1e-6, h->max * 1e-6);
+
+	for (i = 0; i < gHISTOGRAM_BUCKETS; ++i)
+	{
+		if (h->buckets[i] > fullest) fullest = h->buckets[i];
+	}
+
+	for (i = 0; i < gHISTOGRAM_BUCKETS; ++i)
+	{
+		if (h->buckets[i] == 0) continue;
+
+		const int32_t length = (int32_t)((uint64_t)h->buckets[i] * gHISTOGRAM_BAR_LENGTH / fullest);
+		printf("  %9.3f ms %8u |%.*s \n", bucketStart(i) * 1e-3, h->buckets[i], length > 0 ? length : 1,
+		       "##################################################");
+	}
+}
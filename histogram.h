@@ -0,0 +1,57 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <stdint.h>
+
+
+/*----- CONSTANTS -----*/
+/** \brief Number of sub-buckets of each power of two of a histogram, and its base 2 logarithm.
+ * The width of a bucket is at most 1/gHISTOGRAM_SUB_BUCKETS of its values*/
+#define gHISTOGRAM_SUB_BUCKET_BITS 5
+#define gHISTOGRAM_SUB_BUCKETS (1 << gHISTOGRAM_SUB_BUCKET_BITS)
+
+/** \brief Number of buckets of a histogram : one per microsecond below 2 * gHISTOGRAM_SUB_BUCKETS microseconds,
+ * then gHISTOGRAM_SUB_BUCKETS per power of two, up to 2^40 microseconds*/
+#define gHISTOGRAM_BUCKETS ((42 - gHISTOGRAM_SUB_BUCKET_BITS) * gHISTOGRAM_SUB_BUCKETS)
+
+
+/*----- STRUCTURES -----*/
+/** \brief Structure of a histogram of durations, with log-linear buckets : recording a duration is O(1) and never allocates,
+ * and the percentiles are read with a relative error below 1/gHISTOGRAM_SUB_BUCKETS
+ * \param buckets : number of durations recorded in each bucket
+ * \param count : number of durations recorded
+ * \param sum : sum of the durations recorded, in nanoseconds
+ * \param min : smallest duration recorded, in nanoseconds
+ * \param max : greatest duration recorded, in nanoseconds*/
+typedef struct Histogram
+{
+	uint32_t buckets[gHISTOGRAM_BUCKETS];
+	uint64_t count;
+	uint64_t sum;
+	uint64_t min;
+	uint64_t max;
+} Histogram;
+
+
+/*----- FUNCTION PROTOTYPES -----*/
+/** \brief Initialize an empty histogram
+ * \param h : histogram to initialize*/
+void histogramInit(Histogram* h);
+
+/** \brief Record a duration in a histogram
+ * \param h : histogram
+ * \param nanoseconds : duration to record*/
+void histogramRecord(Histogram* h, const uint64_t nanoseconds);
+
+/** \brief Get a percentile of the durations recorded in a histogram
+ * \param h : histogram
+ * \param percentile : percentile to get, between 0 and 100
+ * \return duration in nanoseconds, the middle of the bucket of the percentile. 0 if the histogram is empty*/
+uint64_t histogramPercentile(const Histogram* h, const double percentile);
+
+/** \brief Print the count, the mean, the percentiles 50, 95 and 99 and the maximum of a histogram, then a bar per non empty bucket
+ * \param h : histogram
+ * \param title : name of the durations recorded*/
+void histogramPrint(const Histogram* h, const char* title);
+
+#endif
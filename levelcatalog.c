@@ -0,0 +1,311 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "levelcatalog.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+
+/*----- CONSTANTS -----*/
+/** \brief Size of a path built from a directory and a file name, terminating character included*/
+#define gMAX_CATALOG_PATH 512
+
+/** \brief Greatest number of a level. Names with greater numbers are ignored*/
+#define gMAX_LEVEL_NUMBER 99999999
+
+
+/*----- INTERNAL FUNCTIONS -----*/
+/** \brief Get the number of a level from the name of its file : lvlN.txt or lvlN.lvl, N > 0
+ * \param name : name of the file, without directory
+ * \return number of the level. 0 if the name isn't the name of a level file*/
+static int32_t levelNumber(const char* name)
+{
+	const char* c = name + 3;
+	int32_t number = 0;
+
+	if (strncmp(name, "lvl", 3) != 0 || strlen(name) >= gMAX_LEVEL_FILE_NAME) return 0;
+
+	for (; *c >= '0' && *c <= '9'; ++c)
+	{
+		number = number * 10 + (*c - '0');
+		if (number > gMAX_LEVEL_NUMBER) return 0;
+	}
+
+	return strcmp(c, gLEVEL_TEXT_EXTENSION) == 0 || strcmp(c, gLEVEL_BINARY_EXTENSION) == 0 ? number : 0;
+}
+
+/** \brief Build the path of a file of a directory
+ * \param path : string to fill, of gMAX_CATALOG_PATH characters
+ * \param directory : directory of the file
+ * \param name : name of the file
+ * \return false if the path is too long*/
+static bool joinPath(char* path, const char* directory, const char* name)
+{
+	const int length = snprintf(path, gMAX_CATALOG_PATH, "%s/%s", directory, name);
+	return length > 0 && length < gMAX_CATALOG_PATH;
+}
+
+/** \brief Add a level at the end of a catalog, and fill its file fields. The array of levels grows if it is full
+ * \param c : catalog
+ * \param name : name of the level file
+ * \param modificationTime : last modification time of the file
+ * \param size : size of the file
+ * \return false if the allocation failed*/
+static bool addLevel(LevelCatalog* c, const char* name, const int64_t modificationTime, const int64_t size)
+{
+	LevelInfo* level;
+
+	if (c->numberOfLevels == c->capacity)
+	{
+		const int32_t capacity = c->capacity ? c->capacity * 2 : 64;
+		LevelInfo* levels = (LevelInfo*)realloc(c->levels, capacity * sizeof(LevelInfo));
+		if (!levels) return false;
+
+		c->levels = levels;
+		c->capacity = capacity;
+	}
+
+	level = &c->levels[c->numberOfLevels++];
+	memset(level, 0, sizeof(LevelInfo));
+	strcpy(level->fileName, name);
+	level->number = levelNumber(name);
+	level->modificationTime = modificationTime;
+	level->size = size;
+
+	return true;
+}
+
+/** \brief Add all the level files of a directory to a catalog, in the order of the directory
+ * \param c : catalog
+ * \param directory : directory to list
+ * \return false if the directory can't be listed*/
+static bool listDirectory(LevelCatalog* c, const char* directory)
+{
+	char path[gMAX_CATALOG_PATH];
+
+#ifdef _WIN32
+	WIN32_FIND_DATAA data;
+
+	if (!joinPath(path, directory, "lvl*")) return false;
+
+	HANDLE find = FindFirstFileA(path, &data);
+	if (find == INVALID_HANDLE_VALUE) return GetLastError() == ERROR_FILE_NOT_FOUND;
+
+	/*The listing gives the time and the size : no file is opened*/
+	do
+	{
+		if (!(data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) && levelNumber(data.cFileName) != 0)
+		{
+			const int64_t time = (int64_t)data.ftLastWriteTime.dwHighDateTime << 32 | data.ftLastWriteTime.dwLowDateTime;
+			const int64_t size = (int64_t)data.nFileSizeHigh << 32 | data.nFileSizeLow;
+			if (!addLevel(c, data.cFileName, time, size)) break;
+		}
+	} while (FindNextFileA(find, &data));
+
+	FindClose(find);
+#else
+	struct dirent* entry;
+	struct stat status;
+
+	DIR* dir = opendir(directory);
+	if (!dir) return false;
+
+	while ((entry = readdir(dir)) != NULL)
+	{
+		if (levelNumber(entry->d_name) == 0 || !joinPath(path, directory, entry->d_name)) continue;
+
+		if (stat(path, &status) == 0 && S_ISREG(status.st_mode))
+		{
+			if (!addLevel(c, entry->d_name, (int64_t)status.st_mtime, (int64_t)status.st_size)) break;
+		}
+	}
+
+	closedir(dir);
+#endif
+
+	return true;
+}
+
+/** \brief Compare two levels by number, the binary file of a level first. Used by qsort()
+ * \param a : pointer to the first LevelInfo
+ * \param b : pointer to the second LevelInfo
+ * \return negative if a comes first, positive if b comes first*/
+static int compareLevels(const void* a, const void* b)
+{
+	const LevelInfo* l1 = (const LevelInfo*)a;
+	const LevelInfo* l2 = (const LevelInfo*)b;
+
+	if (l1->number != l2->number) return l1->number < l2->number ? -1 : 1;
+	return (int)levelFileFormat(l2->fileName) - (int)levelFileFormat(l1->fileName);
+}
+
+/** \brief Compare two levels by file name. Used by qsort() and bsearch()
+ * \param a : pointer to the first LevelInfo
+ * \param b : pointer to the second LevelInfo
+ * \return strcmp() of their file names*/
+static int compareFileNames(const void* a, const void* b)
+{
+	return strcmp(((const LevelInfo*)a)->fileName, ((const LevelInfo*)b)->fileName);
+}
+
+/** \brief Read the index file of a directory
+ * \param index : output parameter, catalog of the levels of the index, sorted by file name
+ * \param directory : directory of the index file*/
+static void readIndex(LevelCatalog* index, const char* directory)
+{
+	char path[gMAX_CATALOG_PATH];
+	LevelInfo l;
+	long long time, size;
+
+	if (!joinPath(path, directory, gLEVEL_INDEX_FILE)) return;
+
+	FILE* f = fopen(path, "r");
+	if (!f) return;
+
+	/*One line per level : file name, time, size, numbers of moving particles, non moving particles and walls, high scores*/
+	while (fscanf(f, "%63s %lld %lld %d %d %d %d %d %d", l.fileName, &time, &size, &l.numberOfMovingParticles,
+	              &l.numberOfNonMovingParticles, &l.numberOfWalls, &l.highScores[0], &l.highScores[1], &l.highScores[2]) == 9)
+	{
+		if (levelNumber(l.fileName) == 0 || !addLevel(index, l.fileName, time, size)) continue;
+
+		LevelInfo* level = &index->levels[index->numberOfLevels - 1];
+		level->numberOfMovingParticles = l.numberOfMovingParticles;
+		level->numberOfNonMovingParticles = l.numberOfNonMovingParticles;
+		level->numberOfWalls = l.numberOfWalls;
+		memcpy(level->highScores, l.highScores, sizeof(l.highScores));
+	}
+
+	fclose(f);
+	qsort(index->levels, index->numberOfLevels, sizeof(LevelInfo), compareFileNames);
+}
+
+/** \brief Write the index file of a directory
+ * \param c : catalog of the levels of the directory
+ * \param directory : directory of the index file*/
+static void writeIndex(const LevelCatalog* c, const char* directory)
+{
+	char path[gMAX_CATALOG_PATH];
+	int32_t i;
+
+	if (!joinPath(path, directory, gLEVEL_INDEX_FILE)) return;
+
+	FILE* f = fopen(path, "w");
+	if (!f)
+	{
+		printf("ERROR: Can't write the level index %s \n", path);
+		return;
+	}
+
+	for (i = 0; i < c->numberOfLevels; ++i)
+	{
+		const LevelInfo* l = &c->levels[i];
+		fprintf(f, "%s %lld %lld %d %d %d %d %d %d\n", l->fileName, (long long)l->modificationTime, (long long)l->size,
+		        l->numberOfMovingParticles, l->numberOfNonMovingParticles, l->numberOfWalls, l->highScores[0], l->highScores[1], l->highScores[2]);
+	}
+
+	fclose(f);
+}
+
+/** \brief Fill the metadata of a level by opening its file. A binary file is mapped and checked, without parsing
+ * \param l : level with its file fields set
+ * \param directory : directory of the level file
+ * \return false if the file can't be read or is invalid*/
+static bool readLevelInfo(LevelInfo* l, const char* directory)
+{
+	char path[gMAX_CATALOG_PATH];
+	LevelFile f;
+
+	if (!joinPath(path, directory, l->fileName) || !levelFileOpen(&f, path)) return false;
+
+	l->numberOfMovingParticles = f.header->numberOfMovingParticles;
+	l->numberOfNonMovingParticles = f.header->numberOfNonMovingParticles;
+	l->numberOfWalls = f.header->numberOfWalls;
+	memcpy(l->highScores, f.header->highScores, sizeof(l->highScores));
+
+	levelFileClose(&f);
+	return true;
+}
+
+
+/*----- LEVEL CATALOG FUNCTIONS -----*/
+void levelCatalogInit(LevelCatalog* c)
+{
+	memset(c, 0, sizeof(LevelCatalog));
+}
+
+bool levelCatalogScan(LevelCatalog* c, const char* directory)
+{
+	LevelCatalog index;
+	int32_t i, numberOfLevels = 0;
+
+	c->numberOfLevels = 0;
+	c->numberOfFilesRead = 0;
+	if (!listDirectory(c, directory))
+	{
+		c->numberOfLevels = 0; //The levels listed before the error
+		return false;
+	}
+
+	levelCatalogInit(&index);
+	readIndex(&index, directory);
+
+	/*By number, the binary file of a level before its text file*/
+	qsort(c->levels, c->numberOfLevels, sizeof(LevelInfo), compareLevels);
+
+	for (i = 0; i < c->numberOfLevels; ++i)
+	{
+		LevelInfo* l = &c->levels[i];
+
+		/*The text file of a level with a binary file is ignored*/
+		if (numberOfLevels > 0 && c->levels[numberOfLevels - 1].number == l->number) continue;
+
+		/*The metadata of an unchanged file are the ones of the index. The others are read from the file*/
+		const LevelInfo* cached = (const LevelInfo*)bsearch(l, index.levels, index.numberOfLevels, sizeof(LevelInfo), compareFileNames);
+		if (cached && cached->modificationTime == l->modificationTime && cached->size == l->size)
+		{
+			c->levels[numberOfLevels] = *cached;
+			c->levels[numberOfLevels].number = l->number;
+		}
+		else if (readLevelInfo(l, directory))
+		{
+			c->levels[numberOfLevels] = *l;
+			c->numberOfFilesRead++;
+		}
+		else continue;
+
+		numberOfLevels++;
+	}
+	c->numberOfLevels = numberOfLevels;
+
+	/*The index is written again only if a level was added, modified or removed*/
+	if (c->numberOfFilesRead > 0 || c->numberOfLevels != index.numberOfLevels) writeIndex(c, directory);
+
+	levelCatalogFree(&index);
+	return true;
+}
+
+int32_t levelCatalogFind(const LevelCatalog* c, const int32_t number)
+{
+	int32_t begin = 0, end = c->numberOfLevels;
+
+	/*Binary search : the levels are sorted by number*/
+	while (begin < end)
+	{
+		const int32_t middle = begin + (end - begin) / 2;
+
+		if (c->levels[middle].number < number) begin = middle + 1;
+		else end = middle;
+	}
+	return begin < c->numberOfLevels && c->levels[begin].number == number ? begin : -1;
+}
+
+void levelCatalogFree(LevelCatalog* c)
+{
+	free(c->levels);
+	levelCatalogInit(c);
+}
@@ -0,0 +1,76 @@
+#ifndef LEVELCATALOG_H
+#define LEVELCATALOG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "levelfile.h"
+
+
+/*----- CONSTANTS -----*/
+/** \brief Size of the file name of a level, terminating character included. Longer names are ignored*/
+#define gMAX_LEVEL_FILE_NAME 64
+
+/** \brief Name of the index file of a catalog, in the directory of the levels*/
+#define gLEVEL_INDEX_FILE "levelindex.txt"
+
+
+/*----- STRUCTURES -----*/
+/** \brief Structure of the metadata of a level file, kept in the index of the catalog
+ * \param fileName : name of the level file, without directory : lvlN.txt or lvlN.lvl
+ * \param number : number N of the level
+ * \param modificationTime : last modification time of the file, in the unit of the system. Only compared for equality
+ * \param size : size of the file, in bytes
+ * \param numberOfMovingParticles : number of moving particles of the level
+ * \param numberOfNonMovingParticles : number of non moving particles of the level
+ * \param numberOfWalls : number of walls of the level
+ * \param highScores : the three high scores of the level*/
+typedef struct LevelInfo
+{
+	char fileName[gMAX_LEVEL_FILE_NAME];
+	int32_t number;
+	int64_t modificationTime;
+	int64_t size;
+	int32_t numberOfMovingParticles;
+	int32_t numberOfNonMovingParticles;
+	int32_t numberOfWalls;
+	int32_t highScores[3];
+} LevelInfo;
+
+
+/** \brief Structure of a catalog of the levels of a directory. The metadata of the files unchanged since the last scan are read
+ * from the index file, so that only new or modified level files are opened
+ * \param levels : levels found, by increasing number. A level with both files is listed once, with its binary file, see loadLevel()
+ * \param numberOfLevels : number of levels found
+ * \param capacity : number of levels allocated in levels
+ * \param numberOfFilesRead : number of level files opened by the last scan, because the index didn't know them*/
+typedef struct LevelCatalog
+{
+	LevelInfo* levels;
+	int32_t numberOfLevels;
+	int32_t capacity;
+	int32_t numberOfFilesRead;
+} LevelCatalog;
+
+
+/*----- FUNCTION PROTOTYPES -----*/
+/** \brief Initialize an empty catalog
+ * \param c : catalog to initialize*/
+void levelCatalogInit(LevelCatalog* c);
+
+/** \brief List the level files of a directory. The index file of the directory is read first, and written again if a level changed
+ * \param c : catalog, filled again
+ * \param directory : directory of the levels and of the index file
+ * \return false if the directory can't be listed. The catalog is then empty*/
+bool levelCatalogScan(LevelCatalog* c, const char* directory);
+
+/** \brief Find a level of a catalog by number
+ * \param c : catalog
+ * \param number : number of the level
+ * \return index of the level in the catalog. -1 if there is none*/
+int32_t levelCatalogFind(const LevelCatalog* c, const int32_t number);
+
+/** \brief Free a catalog. It is empty afterwards and can be used again
+ * \param c : catalog to free*/
+void levelCatalogFree(LevelCatalog* c);
+
+#endif
@@ -0,0 +1,284 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "chargecore.h"
+#include "levelfile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+/*----- CONSTANTS -----*/
+/** \brief Offset basis and prime of the 32 bits FNV-1a hash*/
+#define gFNV_OFFSET_BASIS 2166136261u
+#define gFNV_PRIME 16777619u
+
+
+/*----- INTERNAL FUNCTIONS -----*/
+/** \brief Get the size of the image of a level file
+ * \param numberOfMovingParticles : number of moving particles
+ * \param numberOfNonMovingParticles : number of non moving particles
+ * \param numberOfWalls : number of walls
+ * \return size in bytes. 0 if a number is negative or above the number of elements a level can hold*/
+static size_t imageSize(const int32_t numberOfMovingParticles, const int32_t numberOfNonMovingParticles, const int32_t numberOfWalls)
+{
+	if (numberOfMovingParticles < 0 || numberOfNonMovingParticles < 0 || numberOfWalls < 0
+		|| (int64_t)numberOfMovingParticles + numberOfNonMovingParticles > gMAX_PARTICLES || numberOfWalls > gMAX_WALL)
+		return 0;
+
+	return sizeof(LevelFileHeader)
+		+ ((size_t)numberOfMovingParticles * 2 + (size_t)numberOfNonMovingParticles * 3 + (size_t)numberOfWalls * 4) * sizeof(int32_t);
+}
+
+/** \brief Point the arrays of a level file to their place in its image, after the header
+ * \param f : level file with its header set*/
+static void locateArrays(LevelFile* f)
+{
+	f->movingParticles = (int32_t*)(f->header + 1);
+	f->nonMovingParticles = f->movingParticles + 2 * f->header->numberOfMovingParticles;
+	f->walls = f->nonMovingParticles + 3 * f->header->numberOfNonMovingParticles;
+}
+
+/** \brief Map a whole file in memory, privately : the changes made in memory are not written back
+ * \param filename : name of the file
+ * \param size : output parameter, size of the file
+ * \return pointer to the mapping. NULL if the file can't be mapped or is smaller than a LevelFileHeader*/
+static void* mapFile(const char* filename, size_t* size)
+{
+	void* view = NULL;
+
+#ifdef _WIN32
+	LARGE_INTEGER fileSize;
+	HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) return NULL;
+
+	if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart >= (LONGLONG)sizeof(LevelFileHeader))
+	{
+		/*The view keeps the mapping alive once both handles are closed*/
+		HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+		if (mapping)
+		{
+			view = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+			CloseHandle(mapping);
+		}
+		*size = (size_t)fileSize.QuadPart;
+	}
+	CloseHandle(file);
+#else
+	struct stat status;
+	const int file = open(filename, O_RDONLY);
+	if (file == -1) return NULL;
+
+	if (fstat(file, &status) == 0 && status.st_size >= (off_t)sizeof(LevelFileHeader))
+	{
+		/*The mapping stays valid once the file is closed*/
+		view = mmap(NULL, (size_t)status.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+		if (view == MAP_FAILED) view = NULL;
+		*size = (size_t)status.st_size;
+	}
+	close(file);
+#endif
+
+	return view;
+}
+
+/** \brief Unmap a file mapped by mapFile()
+ * \param view : pointer to the mapping
+ * \param size : size of the file*/
+static void unmapFile(void* view, const size_t size)
+{
+#ifdef _WIN32
+	(void)size;
+	UnmapViewOfFile(view);
+#else
+	munmap(view, size);
+#endif
+}
+
+/** \brief Map a binary level file and check it : magic, version, size matching the numbers of particles and walls, checksum
+ * \param f : output parameter, level file opened
+ * \param filename : name of the level file
+ * \return false if the file can't be mapped or is invalid*/
+static bool openBinary(LevelFile* f, const char* filename)
+{
+	size_t size = 0;
+	void* view = mapFile(filename, &size);
+	if (!view) return false;
+
+	f->header = (LevelFileHeader*)view;
+	f->size = size;
+	f->mapped = true;
+
+	if (f->header->magic != gLEVEL_FILE_MAGIC || f->header->version != gLEVEL_FILE_VERSION
+		|| imageSize(f->header->numberOfMovingParticles, f->header->numberOfNonMovingParticles, f->header->numberOfWalls) != size
+		|| levelFileChecksum(f) != f->header->checksum)
+	{
+		unmapFile(view, size);
+		memset(f, 0, sizeof(LevelFile));
+		return false;
+	}
+
+	locateArrays(f);
+	return true;
+}
+
+/** \brief Parse a text level file into an allocated image
+ * \param f : output parameter, level file opened
+ * \param file : level file, open at its beginning
+ * \return false if a number is missing or invalid*/
+static bool openText(LevelFile* f, FILE* file)
+{
+	int32_t scores[3], goal[4], counts[3];
+	int32_t i;
+
+	/*High scores, goal, then numbers of moving particles, non moving particles and walls*/
+	if (fscanf(file, "%d %d %d", &scores[0], &scores[1], &scores[2]) != 3
+		|| fscanf(file, "%d %d %d %d", &goal[0], &goal[1], &goal[2], &goal[3]) != 4
+		|| fscanf(file, "%d %d %d", &counts[0], &counts[1], &counts[2]) != 3
+		|| !levelFileCreate(f, counts[0], counts[1], counts[2]))
+		return false;
+
+	memcpy(f->header->highScores, scores, sizeof(scores));
+	memcpy(f->header->goal, goal, sizeof(goal));
+
+	/*Moving particles, non moving particles and walls : their arrays follow each other in the image*/
+	for (i = 0; i < 2 * counts[0] + 3 * counts[1] + 4 * counts[2]; ++i)
+	{
+		if (fscanf(file, "%d", &f->movingParticles[i]) != 1)
+		{
+			levelFileClose(f);
+			return false;
+		}
+	}
+	return true;
+}
+
+
+/*----- LEVEL FILE FUNCTIONS -----*/
+bool levelFileCreate(LevelFile* f, const int32_t numberOfMovingParticles, const int32_t numberOfNonMovingParticles, const int32_t numberOfWalls)
+{
+	const size_t size = imageSize(numberOfMovingParticles, numberOfNonMovingParticles, numberOfWalls);
+
+	memset(f, 0, sizeof(LevelFile));
+	if (size == 0) return false;
+
+	f->header = (LevelFileHeader*)calloc(1, size);
+	if (!f->header) return false;
+
+	f->size = size;
+	f->header->magic = gLEVEL_FILE_MAGIC;
+	f->header->version = gLEVEL_FILE_VERSION;
+	f->header->numberOfMovingParticles = numberOfMovingParticles;
+	f->header->numberOfNonMovingParticles = numberOfNonMovingParticles;
+	f->header->numberOfWalls = numberOfWalls;
+	locateArrays(f);
+
+	return true;
+}
+
+bool levelFileOpen(LevelFile* f, const char* filename)
+{
+	uint32_t magic = 0;
+	bool opened;
+
+	memset(f, 0, sizeof(LevelFile));
+
+	FILE* file = fopen(filename, "rb");
+	if (!file) return false;
+
+	/*The format is given by the first bytes, whatever the name of the file*/
+	if (fread(&magic, sizeof(magic), 1, file) == 1 && magic == gLEVEL_FILE_MAGIC)
+	{
+		fclose(file);
+		opened = openBinary(f, filename);
+	}
+	else
+	{
+		rewind(file);
+		opened = openText(f, file);
+		fclose(file);
+	}
+
+	if (!opened) printf("ERROR: Invalid level file %s \n", filename);
+	return opened;
+}
+
+bool levelFileWrite(LevelFile* f, const char* filename, const ELevelFormat format)
+{
+	const LevelFileHeader* h = f->header;
+	bool written;
+	int32_t i;
+
+	FILE* file = fopen(filename, format == ELevelFormat_BINARY ? "wb" : "w");
+	if (!file) return false;
+
+	if (format == ELevelFormat_BINARY)
+	{
+		f->header->checksum = levelFileChecksum(f);
+		written = fwrite(f->header, f->size, 1, file) == 1;
+	}
+	else
+	{
+		fprintf(file, "%d %d %d\n", h->highScores[0], h->highScores[1], h->highScores[2]);
+		fprintf(file, "%d %d %d %d\n", h->goal[0], h->goal[1], h->goal[2], h->goal[3]);
+		fprintf(file, "%d %d %d\n", h->numberOfMovingParticles, h->numberOfNonMovingParticles, h->numberOfWalls);
+
+		for (i = 0; i < h->numberOfMovingParticles; ++i)
+		{
+			const int32_t* p = &f->movingParticles[2 * i];
+			fprintf(file, "%d %d\n", p[0], p[1]);
+		}
+		for (i = 0; i < h->numberOfNonMovingParticles; ++i)
+		{
+			const int32_t* p = &f->nonMovingParticles[3 * i];
+			fprintf(file, "%d %d %d\n", p[0], p[1], p[2]);
+		}
+		for (i = 0; i < h->numberOfWalls; ++i)
+		{
+			const int32_t* w = &f->walls[4 * i];
+			fprintf(file, "%d %d %d %d\n", w[0], w[1], w[2], w[3]);
+		}
+		written = !ferror(file);
+	}
+
+	return fclose(file) == 0 && written;
+}
+
+void levelFileClose(LevelFile* f)
+{
+	if (f->mapped) unmapFile(f->header, f->size);
+	else free(f->header);
+
+	memset(f, 0, sizeof(LevelFile));
+}
+
+ELevelFormat levelFileFormat(const char* filename)
+{
+	const size_t length = strlen(filename), extensionLength = strlen(gLEVEL_BINARY_EXTENSION);
+
+	return length >= extensionLength && strcmp(filename + length - extensionLength, gLEVEL_BINARY_EXTENSION) == 0
+		? ELevelFormat_BINARY : ELevelFormat_TEXT;
+}
+
+uint32_t levelFileChecksum(const LevelFile* f)
+{
+	const size_t begin = offsetof(LevelFileHeader, checksum) + sizeof(uint32_t);
+
+	return levelFileHash((const unsigned char*)f->header + begin, f->size - begin);
+}
+
+uint32_t levelFileHash(const void* data, const size_t size)
+{
+	const unsigned char* bytes = (const unsigned char*)data;
+	uint32_t hash = gFNV_OFFSET_BASIS;
+	size_t i;
+
+	for (i = 0; i < size; ++i) hash = (hash ^ bytes[i]) * gFNV_PRIME;
+	return hash;
+}
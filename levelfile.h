@@ -0,0 +1,119 @@
+#ifndef LEVELFILE_H
+#define LEVELFILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+
+/*----- CONSTANTS -----*/
+/** \brief First four bytes of a binary level file : "CHGL". Read on a machine of the other byte order, it does not match*/
+#define gLEVEL_FILE_MAGIC 0x4C474843u
+
+/** \brief Version of the binary level format written. Files of other versions are rejected*/
+#define gLEVEL_FILE_VERSION 1
+
+/** \brief Extension of the binary level files. Any other extension is a text level file*/
+#define gLEVEL_BINARY_EXTENSION ".lvl"
+
+/** \brief Extension of the text level files*/
+#define gLEVEL_TEXT_EXTENSION ".txt"
+
+
+/*----- ENUMERATIONS -----*/
+/** \brief Formats of the level files*/
+typedef enum ELevelFormat
+{
+	ELevelFormat_TEXT, //Numbers separated by spaces : high scores, goal, counts, then one line per particle and per wall
+	ELevelFormat_BINARY //LevelFileHeader followed by the packed arrays, used in place without parsing
+} ELevelFormat;
+
+
+/*----- STRUCTURES -----*/
+/** \brief Header of a binary level file. It is followed by the arrays of movingParticles, nonMovingParticles and walls (see LevelFile),
+ * without padding. All the fields are 32 bits integers in the byte order of the machine
+ * \param magic : gLEVEL_FILE_MAGIC
+ * \param version : gLEVEL_FILE_VERSION
+ * \param checksum : FNV-1a hash of the file after this field, see levelFileChecksum()
+ * \param highScores : the three high scores of the level
+ * \param goal : x, y, w, h of the goal
+ * \param numberOfMovingParticles : number of moving particles
+ * \param numberOfNonMovingParticles : number of non moving particles
+ * \param numberOfWalls : number of walls*/
+typedef struct LevelFileHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t checksum;
+	int32_t highScores[3];
+	int32_t goal[4];
+	int32_t numberOfMovingParticles;
+	int32_t numberOfNonMovingParticles;
+	int32_t numberOfWalls;
+} LevelFileHeader;
+
+
+/** \brief Structure of the content of a level file : the image of a binary level file, mapped in memory or built in memory.
+ * The arrays follow the header in the image
+ * \param header : header of the image
+ * \param movingParticles : x, y of each moving particle
+ * \param nonMovingParticles : x, y, charge of each non moving particle
+ * \param walls : x, y, w, h of each wall
+ * \param size : size of the image, in bytes
+ * \param mapped : true if the image is a private mapping of a binary file, false if it is allocated*/
+typedef struct LevelFile
+{
+	LevelFileHeader* header;
+	int32_t* movingParticles;
+	int32_t* nonMovingParticles;
+	int32_t* walls;
+	size_t size;
+	bool mapped;
+} LevelFile;
+
+
+/*----- FUNCTION PROTOTYPES -----*/
+/** \brief Allocate the image of a level file with room for the particles and walls. The high scores and the goal are set to 0
+ * \param f : level file to create
+ * \param numberOfMovingParticles : number of moving particles
+ * \param numberOfNonMovingParticles : number of non moving particles
+ * \param numberOfWalls : number of walls
+ * \return false if an allocation failed*/
+bool levelFileCreate(LevelFile* f, const int32_t numberOfMovingParticles, const int32_t numberOfNonMovingParticles, const int32_t numberOfWalls);
+
+/** \brief Open a level file of either format. A binary file is mapped in memory and checked (magic, version, size, checksum) without parsing.
+ * A text file is parsed into an allocated image. The image can be modified : the changes are never written back to the file
+ * \param f : output parameter, level file opened
+ * \param filename : name of the level file
+ * \return false if the file can't be read or is invalid, including more particles than gMAX_PARTICLES or more walls than gMAX_WALL.
+ * Nothing is left to close then*/
+bool levelFileOpen(LevelFile* f, const char* filename);
+
+/** \brief Write a level file. The checksum of the image is updated
+ * \param f : level file to write
+ * \param filename : name of the level file
+ * \param format : format of the file written
+ * \return true if the file was written*/
+bool levelFileWrite(LevelFile* f, const char* filename, const ELevelFormat format);
+
+/** \brief Close a level file : unmap or free its image
+ * \param f : level file to close*/
+void levelFileClose(LevelFile* f);
+
+/** \brief Get the format of a level file from its name
+ * \param filename : name of the level file
+ * \return ELevelFormat_BINARY if the name ends with gLEVEL_BINARY_EXTENSION, ELevelFormat_TEXT otherwise*/
+ELevelFormat levelFileFormat(const char* filename);
+
+/** \brief Compute the checksum of the image of a binary level file : FNV-1a hash of all its bytes after the checksum field
+ * \param f : level file
+ * \return checksum*/
+uint32_t levelFileChecksum(const LevelFile* f);
+
+/** \brief Compute the 32 bits FNV-1a hash of bytes. Hash of levelFileChecksum() and of the records of the score journal
+ * \param data : bytes to hash
+ * \param size : number of bytes
+ * \return hash*/
+uint32_t levelFileHash(const void* data, const size_t size);
+
+#endif
@@ -0,0 +1,25 @@
+#include "platformthread.h"
+
+
+/*----- PLATFORM FUNCTIONS -----*/
+#ifdef _WIN32
+void mutexInit(Mutex* m) { InitializeCriticalSection(m); }
+void mutexDestroy(Mutex* m) { DeleteCriticalSection(m); }
+void mutexLock(Mutex* m) { EnterCriticalSection(m); }
+void mutexUnlock(Mutex* m) { LeaveCriticalSection(m); }
+void conditionInit(Condition* c) { InitializeConditionVariable(c); }
+void conditionDestroy(Condition* c) { (void)c; }
+void conditionWait(Condition* c, Mutex* m) { SleepConditionVariableCS(c, m, INFINITE); }
+void conditionSignal(Condition* c) { WakeConditionVariable(c); }
+void conditionBroadcast(Condition* c) { WakeAllConditionVariable(c); }
+#else
+void mutexInit(Mutex* m) { pthread_mutex_init(m, NULL); }
+void mutexDestroy(Mutex* m) { pthread_mutex_destroy(m); }
+void mutexLock(Mutex* m) { pthread_mutex_lock(m); }
+void mutexUnlock(Mutex* m) { pthread_mutex_unlock(m); }
+void conditionInit(Condition* c) { pthread_cond_init(c, NULL); }
+void conditionDestroy(Condition* c) { pthread_cond_destroy(c); }
+void conditionWait(Condition* c, Mutex* m) { pthread_cond_wait(c, m); }
+void conditionSignal(Condition* c) { pthread_cond_signal(c); }
+void conditionBroadcast(Condition* c) { pthread_cond_broadcast(c); }
+#endif
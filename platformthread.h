@@ -0,0 +1,65 @@
+#ifndef PLATFORMTHREAD_H
+#define PLATFORMTHREAD_H
+
+#include <stdbool.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+
+/*----- TYPES -----*/
+/** \brief Threads, mutexes and condition variables of the platform : Win32 on Windows, pthreads elsewhere.
+ * Internal to the libraries, shared by the thread pool of ChargeCore and the score store of ChargeSupport*/
+#ifdef _WIN32
+typedef HANDLE Thread;
+typedef CRITICAL_SECTION Mutex;
+typedef CONDITION_VARIABLE Condition;
+#else
+typedef pthread_t Thread;
+typedef pthread_mutex_t Mutex;
+typedef pthread_cond_t Condition;
+#endif
+
+
+/*----- FUNCTION PROTOTYPES -----*/
+/** \brief Initialize a mutex, unlocked
+ * \param m : mutex to initialize*/
+void mutexInit(Mutex* m);
+
+/** \brief Destroy an unlocked mutex
+ * \param m : mutex to destroy*/
+void mutexDestroy(Mutex* m);
+
+/** \brief Lock a mutex, waiting for the thread holding it
+ * \param m : mutex to lock*/
+void mutexLock(Mutex* m);
+
+/** \brief Unlock a mutex locked by the calling thread
+ * \param m : mutex to unlock*/
+void mutexUnlock(Mutex* m);
+
+/** \brief Initialize a condition variable
+ * \param c : condition variable to initialize*/
+void conditionInit(Condition* c);
+
+/** \brief Destroy a condition variable no thread waits on
+ * \param c : condition variable to destroy*/
+void conditionDestroy(Condition* c);
+
+/** \brief Unlock a mutex and wait for a condition variable to be signaled, then lock the mutex again. The wake up may be spurious
+ * \param c : condition variable to wait on
+ * \param m : mutex locked by the calling thread*/
+void conditionWait(Condition* c, Mutex* m);
+
+/** \brief Wake one thread waiting on a condition variable
+ * \param c : condition variable*/
+void conditionSignal(Condition* c);
+
+/** \brief Wake all the threads waiting on a condition variable
+ * \param c : condition variable*/
+void conditionBroadcast(Condition* c);
+
+#endif
@@ -0,0 +1,333 @@
+#include <stdlib.h>
+#include <math.h>
+#include "chargecore.h"
+#include "quadtree.h"
+
+
+/*----- INTERNAL FUNCTIONS -----*/
+/** \brief Ensure that the quadtree can store n more nodes. The nodes array may be moved in memory
+ * \param t : quadtree
+ * \param n : number of nodes to add
+ * \return false if the allocation failed*/
+static bool reserveNodes(Quadtree* t, const int32_t n)
+{
+	if (t->numberOfNodes + n > t->nodeCapacity)
+	{
+		int32_t capacity = t->nodeCapacity ? t->nodeCapacity * 2 : 64;
+		while (capacity < t->numberOfNodes + n) capacity *= 2;
+
+		QuadtreeNode* nodes = (QuadtreeNode*)realloc(t->nodes, capacity * sizeof(QuadtreeNode));
+		if (!nodes) return false;
+
+		t->nodes = nodes;
+		t->nodeCapacity = capacity;
+	}
+	return true;
+}
+
+/** \brief Ensure that the quadtree can store n particles
+ * \param t : quadtree
+ * \param n : number of particles
+ * \return false if an allocation failed*/
+static bool reserveParticles(Quadtree* t, const int32_t n)
+{
+	if (n > t->particleCapacity)
+	{
+		int32_t* index = (int32_t*)realloc(t->index, n * sizeof(int32_t));
+		if (index) t->index = index;
+		double* x = (double*)realloc(t->x, n * sizeof(double));
+		if (x) t->x = x;
+		double* y = (double*)realloc(t->y, n * sizeof(double));
+		if (y) t->y = y;
+		double* charge = (double*)realloc(t->charge, n * sizeof(double));
+		if (charge) t->charge = charge;
+
+		if (!index || !x || !y || !charge) return false;
+		t->particleCapacity = n;
+	}
+	return true;
+}
+
+/** \brief Swap two particles of the quadtree arrays
+ * \param t : quadtree
+ * \param i : index of the first particle
+ * \param j : index of the second particle*/
+static void swapParticles(Quadtree* t, const int32_t i, const int32_t j)
+{
+	const int32_t index = t->index[i];
+	const double x = t->x[i], y = t->y[i], charge = t->charge[i];
+
+	t->index[i] = t->index[j];
+	t->x[i] = t->x[j];
+	t->y[i] = t->y[j];
+	t->charge[i] = t->charge[j];
+
+	t->index[j] = index;
+	t->x[j] = x;
+	t->y[j] = y;
+	t->charge[j] = charge;
+}
+
+/** \brief Reorganise the particles [begin, end) so that the ones with a coordinate below split come first
+ * \param t : quadtree
+ * \param begin : first particle to reorganise
+ * \param end : last particle to reorganise (excluded)
+ * \param coordinates : x or y array of the quadtree
+ * \param split : coordinate to split at
+ * \return index of the first particle with a coordinate greater or equal to split*/
+static int32_t partition(Quadtree* t, int32_t begin, int32_t end, const double* coordinates, const double split)
+{
+	while (begin < end)
+	{
+		if (coordinates[begin] < split) ++begin;
+		else swapParticles(t, begin, --end);
+	}
+	return begin;
+}
+
+/** \brief Compute the positive and negative centers of charge of a leaf from its particles
+ * \param t : quadtree
+ * \param node : leaf*/
+static void aggregateLeaf(const Quadtree* t, QuadtreeNode* node)
+{
+	double positive = 0, xPositive = 0, yPositive = 0;
+	double negative = 0, xNegative = 0, yNegative = 0;
+	int32_t i;
+
+	for (i = node->begin; i < node->begin + node->count; ++i)
+	{
+		if (t->charge[i] > 0)
+		{
+			positive += t->charge[i];
+			xPositive += t->charge[i] * t->x[i];
+			yPositive += t->charge[i] * t->y[i];
+		}
+		else if (t->charge[i] < 0)
+		{
+			negative += t->charge[i];
+			xNegative += t->charge[i] * t->x[i];
+			yNegative += t->charge[i] * t->y[i];
+		}
+	}
+
+	node->positiveCharge = positive;
+	node->xPositive = positive != 0 ? xPositive / positive : node->xCenter;
+	node->yPositive = positive != 0 ? yPositive / positive : node->yCenter;
+	node->negativeCharge = negative;
+	node->xNegative = negative != 0 ? xNegative / negative : node->xCenter;
+	node->yNegative = negative != 0 ? yNegative / negative : node->yCenter;
+}
+
+/** \brief Compute the positive and negative centers of charge of a node from its four children
+ * \param t : quadtree
+ * \param node : node with children already aggregated*/
+static void aggregateChildren(const Quadtree* t, QuadtreeNode* node)
+{
+	double positive = 0, xPositive = 0, yPositive = 0;
+	double negative = 0, xNegative = 0, yNegative = 0;
+	int32_t i;
+
+	for (i = node->firstChild; i < node->firstChild + 4; ++i)
+	{
+		const QuadtreeNode* child = &t->nodes[i];
+
+		positive += child->positiveCharge;
+		xPositive += child->positiveCharge * child->xPositive;
+		yPositive += child->positiveCharge * child->yPositive;
+		negative += child->negativeCharge;
+		xNegative += child->negativeCharge * child->xNegative;
+		yNegative += child->negativeCharge * child->yNegative;
+	}
+
+	node->positiveCharge = positive;
+	node->xPositive = positive != 0 ? xPositive / positive : node->xCenter;
+	node->yPositive = positive != 0 ? yPositive / positive : node->yCenter;
+	node->negativeCharge = negative;
+	node->xNegative = negative != 0 ? xNegative / negative : node->xCenter;
+	node->yNegative = negative != 0 ? yNegative / negative : node->yCenter;
+}
+
+/** \brief Subdivide a node while it holds more than gQUADTREE_LEAF_SIZE particles, then aggregate its charges
+ * \param t : quadtree
+ * \param nodeIndex : index of the node. Its area and particles must already be set
+ * \param depth : depth of the node
+ * \return false if an allocation failed*/
+static bool buildNode(Quadtree* t, const int32_t nodeIndex, const int depth)
+{
+	const QuadtreeNode node = t->nodes[nodeIndex];
+	const int32_t end = node.begin + node.count;
+	const double quarterSize = node.halfSize * 0.5;
+	int32_t bounds[5];
+	int32_t i, firstChild;
+
+	if (node.count <= gQUADTREE_LEAF_SIZE || depth >= gQUADTREE_MAX_DEPTH)
+	{
+		aggregateLeaf(t, &t->nodes[nodeIndex]);
+		return true;
+	}
+
+	/*Sort the particles of the node by quadrant : top left, top right, bottom left, bottom right*/
+	bounds[0] = node.begin;
+	bounds[2] = partition(t, node.begin, end, t->y, node.yCenter);
+	bounds[1] = partition(t, node.begin, bounds[2], t->x, node.xCenter);
+	bounds[3] = partition(t, bounds[2], end, t->x, node.xCenter);
+	bounds[4] = end;
+
+	if (!reserveNodes(t, 4)) return false;
+	firstChild = t->numberOfNodes;
+	t->numberOfNodes += 4;
+	t->nodes[nodeIndex].firstChild = firstChild;
+
+	for (i = 0; i < 4; ++i)
+	{
+		QuadtreeNode* child = &t->nodes[firstChild + i];
+		child->xCenter = node.xCenter + (i % 2 ? quarterSize : -quarterSize);
+		child->yCenter = node.yCenter + (i / 2 ? quarterSize : -quarterSize);
+		child->halfSize = quarterSize;
+		child->firstChild = -1;
+		child->begin = bounds[i];
+		child->count = bounds[i + 1] - bounds[i];
+	}
+
+	for (i = 0; i < 4; ++i)
+	{
+		if (!buildNode(t, firstChild + i, depth + 1)) return false;
+	}
+
+	aggregateChildren(t, &t->nodes[nodeIndex]);
+	return true;
+}
+
+/** \brief Add the force applied by a charge on another charge, with the same formula as the direct sum of getAcceleration()
+ * \param x : x coordinate of the charge the force is applied to
+ * \param y : y coordinate of the charge the force is applied to
+ * \param charge : charge the force is applied to
+ * \param xOther : x coordinate of the charge applying the force
+ * \param yOther : y coordinate of the charge applying the force
+ * \param chargeOther : charge applying the force
+ * \param fx : pointer to the x force to increment
+ * \param fy : pointer to the y force to increment*/
+static void addForce(const double x, const double y, const double charge, const double xOther, const double yOther,
+                     const double chargeOther, double* fx, double* fy)
+{
+	const double dx = xOther - x;
+	const double dy = yOther - y;
+	const double d = fmax(sqrt(dx * dx + dy * dy), gMIN_DISTANCE);
+	const double f = -(charge * chargeOther) / (d * d * d);
+
+	*fx += f * dx;
+	*fy += f * dy;
+}
+
+
+/*----- QUADTREE FUNCTIONS -----*/
+bool quadtreeBuild(Quadtree* t, const Real* x, const Real* y, const int32_t* charge, const int32_t n)
+{
+	double xMin = 0, xMax = 0, yMin = 0, yMax = 0;
+	int32_t i;
+
+	t->numberOfNodes = 0;
+	t->numberOfParticles = 0;
+
+	if (!reserveParticles(t, n) || !reserveNodes(t, 1)) return false;
+
+	/*Copy the particles, and get the area they cover*/
+	for (i = 0; i < n; ++i)
+	{
+		t->index[i] = i;
+		t->x[i] = x[i];
+		t->y[i] = y[i];
+		t->charge[i] = charge[i];
+
+		if (i == 0 || x[i] < xMin) xMin = x[i];
+		if (i == 0 || x[i] > xMax) xMax = x[i];
+		if (i == 0 || y[i] < yMin) yMin = y[i];
+		if (i == 0 || y[i] > yMax) yMax = y[i];
+	}
+	t->numberOfParticles = n;
+
+	/*The root is the smallest square containing all the particles*/
+	t->numberOfNodes = 1;
+	t->nodes[0].xCenter = (xMin + xMax) * 0.5;
+	t->nodes[0].yCenter = (yMin + yMax) * 0.5;
+	t->nodes[0].halfSize = fmax(xMax - xMin, yMax - yMin) * 0.5 + 1;
+	t->nodes[0].firstChild = -1;
+	t->nodes[0].begin = 0;
+	t->nodes[0].count = n;
+
+	if (!buildNode(t, 0, 0))
+	{
+		t->numberOfNodes = 0;
+		t->numberOfParticles = 0;
+		return false;
+	}
+	return true;
+}
+
+void quadtreeForce(const Quadtree* t, const int32_t self, const double x, const double y, const int32_t charge,
+                   const double openingAngle, double* fx, double* fy)
+{
+	int32_t stack[4 * gQUADTREE_MAX_DEPTH + 4];
+	int stackSize = 0;
+	int32_t i;
+
+	*fx = 0;
+	*fy = 0;
+
+	if (t->numberOfNodes == 0) return;
+
+	stack[stackSize++] = 0;
+
+	while (stackSize > 0)
+	{
+		const QuadtreeNode* node = &t->nodes[stack[--stackSize]];
+
+		if (node->count == 0) continue;
+
+		if (node->firstChild == -1) //Leaf : direct sum
+		{
+			for (i = node->begin; i < node->begin + node->count; ++i)
+			{
+				if (t->index[i] != self) addForce(x, y, charge, t->x[i], t->y[i], t->charge[i], fx, fy);
+			}
+			continue;
+		}
+
+		/*A node far enough is approximated by its centers of charge. A node containing the charge is always opened*/
+		const double dx = node->xCenter - x;
+		const double dy = node->yCenter - y;
+		const bool inside = fabs(dx) <= node->halfSize && fabs(dy) <= node->halfSize;
+		const double size = 2 * node->halfSize;
+
+		if (!inside && size * size < openingAngle * openingAngle * (dx * dx + dy * dy))
+		{
+			if (node->positiveCharge != 0)
+				addForce(x, y, charge, node->xPositive, node->yPositive, node->positiveCharge, fx, fy);
+			if (node->negativeCharge != 0)
+				addForce(x, y, charge, node->xNegative, node->yNegative, node->negativeCharge, fx, fy);
+		}
+		else
+		{
+			for (i = 0; i < 4; ++i) stack[stackSize++] = node->firstChild + i;
+		}
+	}
+}
+
+void quadtreeFree(Quadtree* t)
+{
+	free(t->nodes);
+	free(t->index);
+	free(t->x);
+	free(t->y);
+	free(t->charge);
+
+	t->nodes = NULL;
+	t->index = NULL;
+	t->x = NULL;
+	t->y = NULL;
+	t->charge = NULL;
+	t->numberOfNodes = 0;
+	t->nodeCapacity = 0;
+	t->numberOfParticles = 0;
+	t->particleCapacity = 0;
+}
@@ -0,0 +1,101 @@
+#ifndef QUADTREE_H
+#define QUADTREE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "forcekernel.h"
+
+
+/*----- CONSTANTS -----*/
+/** \brief Maximum number of particles stored in a leaf of the quadtree before it is subdivided*/
+#define gQUADTREE_LEAF_SIZE 8
+
+/** \brief Maximum depth of the quadtree. Particles sharing the same position end up in a leaf at this depth*/
+#define gQUADTREE_MAX_DEPTH 32
+
+
+/*----- STRUCTURES -----*/
+/** \brief Structure of a node of the quadtree. A node covers a square area of the playable area.
+ * Positive and negative charges are aggregated separately, so that a node of neutral overall charge still has the right effect
+ * \param xCenter : x coordinate of the center of the square
+ * \param yCenter : y coordinate of the center of the square
+ * \param halfSize : half of the length of the square
+ * \param firstChild : index of the first of the four consecutive children. -1 if the node is a leaf
+ * \param begin : index of the first particle of the node in the particle arrays of the quadtree
+ * \param count : number of particles in the node
+ * \param positiveCharge : sum of the positive charges of the node
+ * \param xPositive : x coordinate of the center of the positive charges
+ * \param yPositive : y coordinate of the center of the positive charges
+ * \param negativeCharge : sum of the negative charges of the node
+ * \param xNegative : x coordinate of the center of the negative charges
+ * \param yNegative : y coordinate of the center of the negative charges*/
+typedef struct QuadtreeNode
+{
+	double xCenter;
+	double yCenter;
+	double halfSize;
+	int32_t firstChild;
+	int32_t begin;
+	int32_t count;
+	double positiveCharge;
+	double xPositive;
+	double yPositive;
+	double negativeCharge;
+	double xNegative;
+	double yNegative;
+} QuadtreeNode;
+
+
+/** \brief Structure of a Barnes-Hut quadtree. Rebuilt from the particle positions by quadtreeBuild().
+ * The buffers are kept between two builds and only grow
+ * \param nodes : array of nodes. The root is the node 0
+ * \param numberOfNodes : number of nodes used
+ * \param nodeCapacity : number of nodes allocated
+ * \param index : indices of the particles of the tree in the arrays given to quadtreeBuild(), sorted by node
+ * \param x : x coordinates of the particles, in the same order as index
+ * \param y : y coordinates of the particles, in the same order as index
+ * \param charge : charges of the particles, in the same order as index
+ * \param numberOfParticles : number of particles in the tree
+ * \param particleCapacity : number of particles allocated*/
+typedef struct Quadtree
+{
+	QuadtreeNode* nodes;
+	int32_t numberOfNodes;
+	int32_t nodeCapacity;
+	int32_t* index;
+	double* x;
+	double* y;
+	double* charge;
+	int32_t numberOfParticles;
+	int32_t particleCapacity;
+} Quadtree;
+
+
+/*----- FUNCTION PROTOTYPES -----*/
+/** \brief Build the quadtree from the current position of the particles
+ * \param t : quadtree to build
+ * \param x : x coordinates of the particles
+ * \param y : y coordinates of the particles
+ * \param charge : charges of the particles
+ * \param n : number of particles
+ * \return false if an allocation failed. The quadtree is then empty*/
+bool quadtreeBuild(Quadtree* t, const Real* x, const Real* y, const int32_t* charge, const int32_t n);
+
+/** \brief Sum the forces applied by the particles of the quadtree on a charge.
+ * A node is approximated by its positive and negative centers of charge when its size divided by its distance is below openingAngle
+ * \param t : quadtree built with quadtreeBuild()
+ * \param self : index of the particle to ignore in the sum (the particle the force is computed for). -1 to ignore none
+ * \param x : x coordinate of the charge
+ * \param y : y coordinate of the charge
+ * \param charge : charge
+ * \param openingAngle : 0 gives the exact direct sum, greater values are faster and less accurate
+ * \param fx : pointer to output parameter x force
+ * \param fy : pointer to output parameter y force*/
+void quadtreeForce(const Quadtree* t, const int32_t self, const double x, const double y, const int32_t charge,
+                   const double openingAngle, double* fx, double* fy);
+
+/** \brief Free the buffers of a quadtree. The quadtree can be built again afterwards
+ * \param t : quadtree to free*/
+void quadtreeFree(Quadtree* t);
+
+#endif
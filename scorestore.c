@@ -0,0 +1,395 @@
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include "scorestore.h"
+#include "levelfile.h"
+#include "platformthread.h"
+
+
+/*----- CONSTANTS -----*/
+/** \brief The journal is compacted when it holds more than gSCORE_COMPACT_RATIO records per level, plus gSCORE_COMPACT_MARGIN*/
+#define gSCORE_COMPACT_RATIO 2
+#define gSCORE_COMPACT_MARGIN 64
+
+
+/*----- STRUCTURES -----*/
+/** \brief Structure of the high scores of a level, in the table of the store and in the records of the journal
+ * \param level : number of the level. 0 for an empty place of the table
+ * \param scores : the three high scores of the level
+ * \param checksum : FNV-1a hash of level and scores. Only set in the journal*/
+typedef struct ScoreRecord
+{
+	int32_t level;
+	int32_t scores[3];
+	uint32_t checksum;
+} ScoreRecord;
+
+
+/** \brief Structure of a score store
+ * \param journalFile : name of the journal
+ * \param table : high scores by level, hash table with linear probing
+ * \param capacity : number of places of the table, a power of 2
+ * \param count : number of levels in the table
+ * \param journalRecords : number of records in the journal. Only used by the thread once the store is opened
+ * \param pending : records waiting to be appended to the journal
+ * \param numberOfPending : number of records in pending
+ * \param pendingCapacity : number of records allocated in pending
+ * \param lock : protects the table against the compaction, and the fields below
+ * \param wake : signaled when a record is pending or when the store is closed
+ * \param thread : thread appending the records to the journal
+ * \param threadStarted : false if the thread couldn't be started. The records are then appended by scoreStoreSet()
+ * \param quit : true when the store is being closed*/
+struct ScoreStore
+{
+	char* journalFile;
+	ScoreRecord* table;
+	int32_t capacity;
+	int32_t count;
+	int32_t journalRecords;
+	ScoreRecord* pending;
+	int32_t numberOfPending;
+	int32_t pendingCapacity;
+	Mutex lock;
+	Condition wake;
+	Thread thread;
+	bool threadStarted;
+	bool quit;
+};
+
+
+/*----- PLATFORM FUNCTIONS -----*/
+#ifdef _WIN32
+static bool replaceFile(const char* from, const char* to) { return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING) != 0; }
+#else
+static bool replaceFile(const char* from, const char* to) { return rename(from, to) == 0; }
+#endif
+
+
+/*----- INTERNAL FUNCTIONS -----*/
+/** \brief Test if the journal of a store is long enough to be compacted
+ * \param s : score store
+ * \return true if the journal holds more than gSCORE_COMPACT_RATIO records per level, plus gSCORE_COMPACT_MARGIN*/
+static bool journalTooLong(const ScoreStore* s)
+{
+	return s->journalRecords > gSCORE_COMPACT_RATIO * s->count + gSCORE_COMPACT_MARGIN;
+}
+
+/** \brief Compute the checksum of a record : FNV-1a hash of its level and scores
+ * \param r : record
+ * \return checksum*/
+static uint32_t recordChecksum(const ScoreRecord* r)
+{
+	return levelFileHash(r, offsetof(ScoreRecord, checksum));
+}
+
+/** \brief Find the place of a level in a table : the place of the level, or the empty place where it would be inserted
+ * \param table : hash table
+ * \param capacity : number of places of the table, a power of 2
+ * \param level : number of the level
+ * \return index of the place*/
+static int32_t findPlace(const ScoreRecord* table, const int32_t capacity, const int32_t level)
+{
+	int32_t i = (int32_t)(((uint32_t)level * 2654435761u) & (uint32_t)(capacity - 1));
+
+	while (table[i].level != 0 && table[i].level != level) i = (i + 1) & (capacity - 1);
+	return i;
+}
+
+/** \brief Set the scores of a level in the table. The table grows when it is half full
+ * \param s : score store
+ * \param level : number of the level
+ * \param scores : the three high scores
+ * \return false if an allocation failed*/
+static bool setInTable(ScoreStore* s, const int32_t level, const int32_t scores[3])
+{
+	int32_t i;
+
+	if (2 * (s->count + 1) > s->capacity)
+	{
+		const int32_t capacity = s->capacity ? s->capacity * 2 : 256;
+		ScoreRecord* table = (ScoreRecord*)calloc(capacity, sizeof(ScoreRecord));
+		if (!table) return false;
+
+		for (i = 0; i < s->capacity; ++i)
+		{
+			if (s->table[i].level != 0) table[findPlace(table, capacity, s->table[i].level)] = s->table[i];
+		}
+		free(s->table);
+		s->table = table;
+		s->capacity = capacity;
+	}
+
+	i = findPlace(s->table, s->capacity, level);
+	if (s->table[i].level == 0) s->count++;
+	s->table[i].level = level;
+	memcpy(s->table[i].scores, scores, 3 * sizeof(int32_t));
+	return true;
+}
+
+/** \brief Append records to the journal
+ * \param s : score store
+ * \param records : records to append, their checksums set
+ * \param n : number of records*/
+static void appendRecords(ScoreStore* s, const ScoreRecord* records, const int32_t n)
+{
+	FILE* f = fopen(s->journalFile, "ab");
+	if (!f || fwrite(records, sizeof(ScoreRecord), n, f) != (size_t)n) printf("ERROR: Can't write the high scores in %s \n", s->journalFile);
+
+	if (f) fclose(f);
+	s->journalRecords += n;
+}
+
+/** \brief Write the journal again with one record per level. The new journal is written beside and then replaces the old one,
+ * so that a crash leaves one of them whole
+ * \param s : score store*/
+static void compactJournal(ScoreStore* s)
+{
+	char* temporaryFile = (char*)malloc(strlen(s->journalFile) + 5);
+	ScoreRecord* records = NULL;
+	int32_t i, n = 0;
+	bool written = false;
+
+	/*Copy of the table : the table may change while the file is written*/
+	mutexLock(&s->lock);
+	if (s->count > 0) records = (ScoreRecord*)malloc(s->count * sizeof(ScoreRecord));
+	for (i = 0; records && i < s->capacity; ++i)
+	{
+		if (s->table[i].level == 0) continue;
+		records[n] = s->table[i];
+		records[n].checksum = recordChecksum(&records[n]);
+		n++;
+	}
+	mutexUnlock(&s->lock);
+
+	if (temporaryFile && (records || s->count == 0))
+	{
+		sprintf(temporaryFile, "%s.tmp", s->journalFile);
+
+		FILE* f = fopen(temporaryFile, "wb");
+		if (f)
+		{
+			written = fwrite(records, sizeof(ScoreRecord), n, f) == (size_t)n;
+			written = fclose(f) == 0 && written && replaceFile(temporaryFile, s->journalFile);
+		}
+	}
+
+	if (written) s->journalRecords = n;
+	else printf("ERROR: Can't compact the high scores in %s \n", s->journalFile);
+
+	free(temporaryFile);
+	free(records);
+}
+
+/** \brief Main function of the thread of a store : append the pending records to the journal, and compact it when it is too long,
+ * until the store is closed
+ * \param s : score store*/
+static void writerLoop(ScoreStore* s)
+{
+	ScoreRecord* records = NULL;
+	int32_t capacity = 0;
+
+	mutexLock(&s->lock);
+	while (true)
+	{
+		while (s->numberOfPending == 0 && !s->quit) conditionWait(&s->wake, &s->lock);
+		if (s->numberOfPending == 0) break; //Closed, with all the records written
+
+		/*Exchange the pending records with the spare buffer, so that scoreStoreSet() never waits for the disk*/
+		ScoreRecord* written = s->pending;
+		const int32_t writtenCapacity = s->pendingCapacity, n = s->numberOfPending;
+		s->pending = records;
+		s->pendingCapacity = capacity;
+		s->numberOfPending = 0;
+		mutexUnlock(&s->lock);
+
+		appendRecords(s, written, n);
+
+		/*The buffer written becomes the spare one*/
+		records = written;
+		capacity = writtenCapacity;
+		mutexLock(&s->lock);
+
+		if (journalTooLong(s))
+		{
+			mutexUnlock(&s->lock);
+			compactJournal(s);
+			mutexLock(&s->lock);
+		}
+	}
+	mutexUnlock(&s->lock);
+
+	free(records);
+}
+
+#ifdef _WIN32
+static DWORD WINAPI writerThread(LPVOID s)
+{
+	writerLoop((ScoreStore*)s);
+	return 0;
+}
+#else
+static void* writerThread(void* s)
+{
+	writerLoop((ScoreStore*)s);
+	return NULL;
+}
+#endif
+
+
+/*----- SCORE STORE FUNCTIONS -----*/
+ScoreStore* scoreStoreOpen(const char* journalFile)
+{
+	ScoreRecord r;
+	bool torn = false;
+
+	ScoreStore* s = (ScoreStore*)calloc(1, sizeof(ScoreStore));
+	if (!s) return NULL;
+
+	s->journalFile = (char*)malloc(strlen(journalFile) + 1);
+	if (!s->journalFile)
+	{
+		free(s);
+		return NULL;
+	}
+	strcpy(s->journalFile, journalFile);
+	mutexInit(&s->lock);
+	conditionInit(&s->wake);
+
+	/*Replay the journal : the last record of a level wins*/
+	FILE* f = fopen(journalFile, "rb");
+	if (f)
+	{
+		size_t read;
+		bool allocated = true;
+		while ((read = fread(&r, 1, sizeof(ScoreRecord), f)) == sizeof(ScoreRecord))
+		{
+			if (r.level <= 0 || r.checksum != recordChecksum(&r))
+			{
+				torn = true;
+				break;
+			}
+			if (!setInTable(s, r.level, r.scores))
+			{
+				allocated = false;
+				break;
+			}
+			s->journalRecords++;
+		}
+		if (read != 0 && read != sizeof(ScoreRecord)) torn = true;
+		fclose(f);
+
+		/*The journal is left as it is : compacting it now would drop the levels not read yet*/
+		if (!allocated)
+		{
+			conditionDestroy(&s->wake);
+			mutexDestroy(&s->lock);
+			free(s->journalFile);
+			free(s->table);
+			free(s);
+			return NULL;
+		}
+	}
+
+	/*Records appended after a cut record would be lost at the next reading*/
+	if (torn)
+	{
+		printf("ERROR: High scores journal %s damaged after %d records \n", journalFile, s->journalRecords);
+		compactJournal(s);
+	}
+	else if (journalTooLong(s)) compactJournal(s);
+
+#ifdef _WIN32
+	s->thread = CreateThread(NULL, 0, writerThread, s, 0, NULL);
+	s->threadStarted = s->thread != NULL;
+#else
+	s->threadStarted = pthread_create(&s->thread, NULL, writerThread, s) == 0;
+#endif
+
+	return s;
+}
+
+bool scoreStoreGet(const ScoreStore* s, const int32_t level, int32_t scores[3])
+{
+	if (!s->table || level <= 0) return false;
+
+	const ScoreRecord* r = &s->table[findPlace(s->table, s->capacity, level)];
+	if (r->level == 0) return false;
+
+	memcpy(scores, r->scores, 3 * sizeof(int32_t));
+	return true;
+}
+
+bool scoreStoreSet(ScoreStore* s, const int32_t level, const int32_t scores[3])
+{
+	ScoreRecord r;
+	bool stored = false;
+
+	if (level <= 0) return false;
+
+	r.level = level;
+	memcpy(r.scores, scores, sizeof(r.scores));
+	r.checksum = recordChecksum(&r);
+
+	mutexLock(&s->lock);
+	if (setInTable(s, level, scores))
+	{
+		if (s->numberOfPending == s->pendingCapacity)
+		{
+			const int32_t capacity = s->pendingCapacity ? s->pendingCapacity * 2 : 16;
+			ScoreRecord* pending = (ScoreRecord*)realloc(s->pending, capacity * sizeof(ScoreRecord));
+			if (pending)
+			{
+				s->pending = pending;
+				s->pendingCapacity = capacity;
+			}
+		}
+
+		if (s->numberOfPending < s->pendingCapacity)
+		{
+			s->pending[s->numberOfPending++] = r;
+			conditionSignal(&s->wake);
+			stored = true;
+		}
+	}
+	mutexUnlock(&s->lock);
+
+	/*Without a thread, the record is written at once*/
+	if (stored && !s->threadStarted)
+	{
+		appendRecords(s, s->pending, s->numberOfPending);
+		s->numberOfPending = 0;
+	}
+
+	return stored;
+}
+
+void scoreStoreClose(ScoreStore* s)
+{
+	if (!s) return;
+
+	/*The thread writes the pending records before it stops*/
+	mutexLock(&s->lock);
+	s->quit = true;
+	conditionSignal(&s->wake);
+	mutexUnlock(&s->lock);
+
+	if (s->threadStarted)
+	{
+#ifdef _WIN32
+		WaitForSingleObject(s->thread, INFINITE);
+		CloseHandle(s->thread);
+#else
+		pthread_join(s->thread, NULL);
+#endif
+	}
+
+	if (journalTooLong(s)) compactJournal(s);
+
+	conditionDestroy(&s->wake);
+	mutexDestroy(&s->lock);
+	free(s->journalFile);
+	free(s->table);
+	free(s->pending);
+	free(s);
+}
@@ -0,0 +1,45 @@
+#ifndef SCORESTORE_H
+#define SCORESTORE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+/*----- CONSTANTS -----*/
+/** \brief Name of the journal of the high scores, in the directory of the levels*/
+#define gSCORE_JOURNAL_FILE "highscores.dat"
+
+
+/*----- STRUCTURES -----*/
+/** \brief High scores of all the levels, kept in memory and saved in an append-only journal.
+ * The journal is a list of records (level, three high scores, checksum), the last record of a level wins. It is written by a thread
+ * of the store, so that saving a score never waits for the disk, and compacted to one record per level when it grows too long*/
+typedef struct ScoreStore ScoreStore;
+
+
+/*----- FUNCTION PROTOTYPES -----*/
+/** \brief Read a journal of high scores and start the thread writing it. A record cut by a crash ends the reading,
+ * and the journal is then compacted so that the next records follow the valid ones
+ * \param journalFile : name of the journal. Created by the first score saved if it doesn't exist
+ * \return the store. NULL if an allocation failed, the journal is then left unchanged*/
+ScoreStore* scoreStoreOpen(const char* journalFile);
+
+/** \brief Get the high scores of a level. O(1)
+ * \param s : score store
+ * \param level : number of the level, above 0
+ * \param scores : output parameter, the three high scores of the level
+ * \return false if the store has no score for the level. scores is then unchanged*/
+bool scoreStoreGet(const ScoreStore* s, const int32_t level, int32_t scores[3]);
+
+/** \brief Set the high scores of a level. The store is updated at once, the record is appended to the journal later by the thread of the store
+ * \param s : score store
+ * \param level : number of the level, above 0
+ * \param scores : the three high scores of the level
+ * \return false if an allocation failed*/
+bool scoreStoreSet(ScoreStore* s, const int32_t level, const int32_t scores[3]);
+
+/** \brief Write the records left, compact the journal if it is too long, stop the thread and free a store
+ * \param s : score store. Can be NULL*/
+void scoreStoreClose(ScoreStore* s);
+
+#endif
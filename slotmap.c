@@ -0,0 +1,123 @@
+#include <stdlib.h>
+#include <string.h>
+#include "slotmap.h"
+
+
+/*----- INTERNAL FUNCTIONS -----*/
+/** \brief Number of generations a slot goes through before its handles repeat*/
+#define gMAX_GENERATION ((uint32_t)(0xFFFFFFFFu >> gHANDLE_SLOT_BITS))
+
+/** \brief Ensure that a slot map can store n slots and elements. The arrays may be moved in memory
+ * \param m : slot map
+ * \param n : number of slots
+ * \return false if an allocation failed*/
+static bool reserveSlots(SlotMap* m, const int32_t n)
+{
+	if (n > m->capacity)
+	{
+		int32_t* indices = (int32_t*)arenaGrow(m->arena, m->indices, m->capacity * sizeof(int32_t), n * sizeof(int32_t));
+		if (indices) m->indices = indices;
+		uint32_t* generations = (uint32_t*)arenaGrow(m->arena, m->generations, m->capacity * sizeof(uint32_t), n * sizeof(uint32_t));
+		if (generations) m->generations = generations;
+		int32_t* slots = (int32_t*)arenaGrow(m->arena, m->slots, m->capacity * sizeof(int32_t), n * sizeof(int32_t));
+		if (slots) m->slots = slots;
+
+		if (!indices || !generations || !slots) return false;
+		m->capacity = n;
+	}
+	return true;
+}
+
+
+/*----- SLOT MAP FUNCTIONS -----*/
+void slotMapInit(SlotMap* m, Arena* arena)
+{
+	memset(m, 0, sizeof(SlotMap));
+	m->firstFree = -1;
+	m->arena = arena;
+}
+
+Handle slotMapInsert(SlotMap* m)
+{
+	int32_t slot;
+
+	/*Reuse a free slot, or take a new one*/
+	if (m->firstFree != -1)
+	{
+		slot = m->firstFree;
+		m->firstFree = m->indices[slot];
+	}
+	else
+	{
+		if (m->numberOfSlots == gMAX_SLOTS) return gNULL_HANDLE;
+		if (m->numberOfSlots == m->capacity)
+		{
+			const int32_t capacity = m->capacity ? m->capacity * 2 : 64;
+			if (!reserveSlots(m, capacity < gMAX_SLOTS ? capacity : gMAX_SLOTS)) return gNULL_HANDLE;
+		}
+
+		slot = m->numberOfSlots++;
+		m->generations[slot] = 1;
+	}
+
+	m->indices[slot] = m->count;
+	m->slots[m->count] = slot;
+	m->count++;
+
+	return (Handle)slot | m->generations[slot] << gHANDLE_SLOT_BITS;
+}
+
+int32_t slotMapRemove(SlotMap* m, const int32_t index)
+{
+	const int32_t slot = m->slots[index];
+	const int32_t last = m->count - 1;
+
+	/*The last element takes the index of the removed one*/
+	m->slots[index] = m->slots[last];
+	m->indices[m->slots[index]] = index;
+	m->count--;
+
+	/*The old handles of the slot become stale, then the slot is free*/
+	m->generations[slot] = m->generations[slot] % gMAX_GENERATION + 1;
+	m->indices[slot] = m->firstFree;
+	m->firstFree = slot;
+
+	return last;
+}
+
+void slotMapSwap(SlotMap* m, const int32_t index1, const int32_t index2)
+{
+	const int32_t slot = m->slots[index1];
+
+	m->slots[index1] = m->slots[index2];
+	m->slots[index2] = slot;
+	m->indices[m->slots[index1]] = index1;
+	m->indices[m->slots[index2]] = index2;
+}
+
+int32_t slotMapIndex(const SlotMap* m, const Handle h)
+{
+	const int32_t slot = (int32_t)(h & (gMAX_SLOTS - 1));
+	int32_t index;
+
+	if (h == gNULL_HANDLE || slot >= m->numberOfSlots || m->generations[slot] != h >> gHANDLE_SLOT_BITS) return -1;
+
+	/*A free slot holds the next free slot instead of an index*/
+	index = m->indices[slot];
+	return index >= 0 && index < m->count && m->slots[index] == slot ? index : -1;
+}
+
+Handle slotMapHandle(const SlotMap* m, const int32_t index)
+{
+	if (index < 0 || index >= m->count) return gNULL_HANDLE;
+
+	return (Handle)m->slots[index] | m->generations[m->slots[index]] << gHANDLE_SLOT_BITS;
+}
+
+void slotMapFree(SlotMap* m)
+{
+	arenaRelease(m->arena, m->indices);
+	arenaRelease(m->arena, m->generations);
+	arenaRelease(m->arena, m->slots);
+	slotMapInit(m, m->arena);
+}
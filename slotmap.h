@@ -0,0 +1,89 @@
+#ifndef SLOTMAP_H
+#define SLOTMAP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "arena.h"
+
+
+/*----- CONSTANTS -----*/
+/** \brief Number of low bits of a handle holding its slot. The high bits hold the generation of the slot*/
+#define gHANDLE_SLOT_BITS 20
+
+/** \brief Number of slots a slot map can hold*/
+#define gMAX_SLOTS (1 << gHANDLE_SLOT_BITS)
+
+/** \brief Handle referring to no element. Never given to an element*/
+#define gNULL_HANDLE 0
+
+
+/*----- TYPES -----*/
+/** \brief Stable reference to an element of a slot map : slot | generation << gHANDLE_SLOT_BITS.
+ * It stays valid while the element exists, whatever the moves of the element in the dense arrays, and becomes stale when it is removed*/
+typedef uint32_t Handle;
+
+
+/*----- STRUCTURES -----*/
+/** \brief Structure of a slot map : gives stable handles to elements stored in dense arrays owned by the caller.
+ * The elements are always stored at the indices [0, count). Removing an element moves the last one in its place, so the arrays stay dense
+ * \param indices : for each slot in use, index of its element in the dense arrays. For each free slot, next free slot, -1 for the last one
+ * \param generations : generation of each slot, never 0. Incremented when its element is removed, so that its old handles become stale
+ * \param slots : slot of each element, by index in the dense arrays
+ * \param capacity : number of slots and elements allocated
+ * \param numberOfSlots : number of slots already used once
+ * \param firstFree : first free slot to reuse. -1 if there is none
+ * \param count : number of elements
+ * \param arena : arena of the arrays. NULL if they are allocated with malloc()*/
+typedef struct SlotMap
+{
+	int32_t* indices;
+	uint32_t* generations;
+	int32_t* slots;
+	int32_t capacity;
+	int32_t numberOfSlots;
+	int32_t firstFree;
+	int32_t count;
+	Arena* arena;
+} SlotMap;
+
+
+/*----- FUNCTION PROTOTYPES -----*/
+/** \brief Initialize an empty slot map
+ * \param m : slot map to initialize
+ * \param arena : arena allocating the arrays of the slot map. NULL to allocate them with malloc()*/
+void slotMapInit(SlotMap* m, Arena* arena);
+
+/** \brief Add an element at the index count of the dense arrays, in a free slot
+ * \param m : slot map
+ * \return handle of the element. gNULL_HANDLE if the slot map is full or if the allocation failed*/
+Handle slotMapInsert(SlotMap* m);
+
+/** \brief Remove the element at an index. The last element takes its index : the caller must move its data the same way in the dense arrays
+ * \param m : slot map
+ * \param index : index of the element to remove, between 0 and count - 1
+ * \return index of the element moved to index before the call (count - 1). Equal to index if the last element was removed*/
+int32_t slotMapRemove(SlotMap* m, const int32_t index);
+
+/** \brief Exchange the indices of two elements. The caller must exchange their data the same way in the dense arrays
+ * \param m : slot map
+ * \param index1 : index of the first element
+ * \param index2 : index of the second element*/
+void slotMapSwap(SlotMap* m, const int32_t index1, const int32_t index2);
+
+/** \brief Get the index of the element of a handle
+ * \param m : slot map
+ * \param h : handle of the element
+ * \return index of the element in the dense arrays. -1 if the handle is gNULL_HANDLE or stale*/
+int32_t slotMapIndex(const SlotMap* m, const Handle h);
+
+/** \brief Get the handle of the element at an index
+ * \param m : slot map
+ * \param index : index of the element in the dense arrays
+ * \return handle of the element. gNULL_HANDLE if there is no element at index*/
+Handle slotMapHandle(const SlotMap* m, const int32_t index);
+
+/** \brief Free a slot map. It is empty afterwards and can be used again, with the same arena. The handles it gave may be given again
+ * \param m : slot map to free*/
+void slotMapFree(SlotMap* m);
+
+#endif
@@ -0,0 +1,284 @@
+#include <stdlib.h>
+#include "threadpool.h"
+#include "platformthread.h"
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+
+/*----- STRUCTURES -----*/
+/** \brief Structure of the tasks left to a thread : the range [begin, end)
+ * \param begin : next task the thread will run
+ * \param end : last task of the range (excluded). Lowered by the threads stealing from this range
+ * \param lock : protects begin and end*/
+typedef struct TaskRange
+{
+	int32_t begin;
+	int32_t end;
+	Mutex lock;
+} TaskRange;
+
+
+/** \brief Structure of a worker thread
+ * \param pool : thread pool of the worker
+ * \param index : index of the worker in the thread pool. The thread calling threadPoolRun() has the index 0
+ * \param thread : handle of the thread*/
+typedef struct Worker
+{
+	ThreadPool* pool;
+	int32_t index;
+	Thread thread;
+} Worker;
+
+
+/** \brief Structure of a thread pool
+ * \param numberOfThreads : number of threads running the tasks, including the thread calling threadPoolRun()
+ * \param workers : numberOfThreads - 1 worker threads, from the index 1
+ * \param ranges : tasks left to each thread
+ * \param lock : protects the fields below
+ * \param wake : signaled when a run starts or when the pool is destroyed
+ * \param done : signaled when the last worker thread finishes a run
+ * \param task : function of the current run
+ * \param context : context of the current run
+ * \param generation : number of runs started. The workers compare it to the last run they did to wait for the next one
+ * \param numberOfRunning : number of worker threads still working on the current run
+ * \param quit : true when the pool is being destroyed*/
+struct ThreadPool
+{
+	int32_t numberOfThreads;
+	Worker* workers;
+	TaskRange* ranges;
+	Mutex lock;
+	Condition wake;
+	Condition done;
+	ThreadPoolTask task;
+	void* context;
+	uint32_t generation;
+	int32_t numberOfRunning;
+	bool quit;
+};
+
+
+/*----- INTERNAL FUNCTIONS -----*/
+/** \brief Take the next task of the range of a thread. If the range is empty, steal half of the range of another thread
+ * \param pool : thread pool
+ * \param index : index of the thread
+ * \return index of the task to run. -1 if there is no task left*/
+static int32_t nextTask(ThreadPool* pool, const int32_t index)
+{
+	TaskRange* own = &pool->ranges[index];
+	int32_t i, task = -1;
+
+	mutexLock(&own->lock);
+	if (own->begin < own->end) task = own->begin++;
+	mutexUnlock(&own->lock);
+
+	/*Steal the second half of the first range found with tasks left, starting from the next thread*/
+	for (i = 1; task == -1 && i < pool->numberOfThreads; ++i)
+	{
+		TaskRange* victim = &pool->ranges[(index + i) % pool->numberOfThreads];
+		int32_t begin = 0, end = 0;
+
+		mutexLock(&victim->lock);
+		if (victim->begin < victim->end)
+		{
+			end = victim->end;
+			begin = victim->begin + (victim->end - victim->begin) / 2;
+			victim->end = begin;
+		}
+		mutexUnlock(&victim->lock);
+
+		if (begin < end)
+		{
+			task = begin;
+
+			mutexLock(&own->lock);
+			own->begin = begin + 1;
+			own->end = end;
+			mutexUnlock(&own->lock);
+		}
+	}
+
+	return task;
+}
+
+/** \brief Run tasks of the current run until there is no task left
+ * \param pool : thread pool
+ * \param index : index of the thread*/
+static void runTasks(ThreadPool* pool, const int32_t index)
+{
+	int32_t task;
+
+	while ((task = nextTask(pool, index)) != -1) pool->task(pool->context, task);
+}
+
+/** \brief Main function of a worker thread : wait for a run, run tasks, signal the end of the run, until the pool is destroyed
+ * \param worker : worker of the thread*/
+static void workerLoop(Worker* worker)
+{
+	ThreadPool* pool = worker->pool;
+	uint32_t generation = 0;
+
+	mutexLock(&pool->lock);
+	while (true)
+	{
+		while (pool->generation == generation && !pool->quit) conditionWait(&pool->wake, &pool->lock);
+		if (pool->quit) break;
+		generation = pool->generation;
+		mutexUnlock(&pool->lock);
+
+		runTasks(pool, worker->index);
+
+		mutexLock(&pool->lock);
+		if (--pool->numberOfRunning == 0) conditionBroadcast(&pool->done);
+	}
+	mutexUnlock(&pool->lock);
+}
+
+#ifdef _WIN32
+static DWORD WINAPI workerThread(LPVOID worker)
+{
+	workerLoop((Worker*)worker);
+	return 0;
+}
+#else
+static void* workerThread(void* worker)
+{
+	workerLoop((Worker*)worker);
+	return NULL;
+}
+#endif
+
+
+/*----- THREAD POOL FUNCTIONS -----*/
+ThreadPool* threadPoolCreate(const int32_t numberOfThreads)
+{
+	int32_t i;
+
+	if (numberOfThreads < 1) return NULL;
+
+	ThreadPool* pool = (ThreadPool*)calloc(1, sizeof(ThreadPool));
+	if (!pool) return NULL;
+
+	pool->workers = (Worker*)calloc(numberOfThreads, sizeof(Worker));
+	pool->ranges = (TaskRange*)calloc(numberOfThreads, sizeof(TaskRange));
+	if (!pool->workers || !pool->ranges)
+	{
+		free(pool->workers);
+		free(pool->ranges);
+		free(pool);
+		return NULL;
+	}
+
+	mutexInit(&pool->lock);
+	conditionInit(&pool->wake);
+	conditionInit(&pool->done);
+	for (i = 0; i < numberOfThreads; ++i) mutexInit(&pool->ranges[i].lock);
+	pool->numberOfThreads = 1;
+
+	/*Start the worker threads. If one can't be started, the pool is destroyed*/
+	for (i = 1; i < numberOfThreads; ++i)
+	{
+		Worker* worker = &pool->workers[i];
+		worker->pool = pool;
+		worker->index = i;
+
+#ifdef _WIN32
+		worker->thread = CreateThread(NULL, 0, workerThread, worker, 0, NULL);
+		if (!worker->thread) break;
+#else
+		if (pthread_create(&worker->thread, NULL, workerThread, worker) != 0) break;
+#endif
+		pool->numberOfThreads++;
+	}
+
+	if (pool->numberOfThreads != numberOfThreads)
+	{
+		threadPoolDestroy(pool);
+		return NULL;
+	}
+	return pool;
+}
+
+void threadPoolDestroy(ThreadPool* pool)
+{
+	int32_t i;
+
+	if (!pool) return;
+
+	mutexLock(&pool->lock);
+	pool->quit = true;
+	conditionBroadcast(&pool->wake);
+	mutexUnlock(&pool->lock);
+
+	for (i = 1; i < pool->numberOfThreads; ++i)
+	{
+#ifdef _WIN32
+		WaitForSingleObject(pool->workers[i].thread, INFINITE);
+		CloseHandle(pool->workers[i].thread);
+#else
+		pthread_join(pool->workers[i].thread, NULL);
+#endif
+	}
+
+	for (i = 0; i < pool->numberOfThreads; ++i) mutexDestroy(&pool->ranges[i].lock);
+	conditionDestroy(&pool->done);
+	conditionDestroy(&pool->wake);
+	mutexDestroy(&pool->lock);
+
+	free(pool->workers);
+	free(pool->ranges);
+	free(pool);
+}
+
+void threadPoolRun(ThreadPool* pool, const int32_t numberOfTasks, ThreadPoolTask task, void* context)
+{
+	int32_t i;
+
+	/*Not worth waking up the workers*/
+	if (!pool || pool->numberOfThreads == 1 || numberOfTasks <= 1)
+	{
+		for (i = 0; i < numberOfTasks; ++i) task(context, i);
+		return;
+	}
+
+	/*Split the tasks in contiguous ranges of the same size. The workers are all waiting, so no lock is needed*/
+	for (i = 0; i < pool->numberOfThreads; ++i)
+	{
+		pool->ranges[i].begin = (int32_t)((int64_t)numberOfTasks * i / pool->numberOfThreads);
+		pool->ranges[i].end = (int32_t)((int64_t)numberOfTasks * (i + 1) / pool->numberOfThreads);
+	}
+
+	mutexLock(&pool->lock);
+	pool->task = task;
+	pool->context = context;
+	pool->numberOfRunning = pool->numberOfThreads - 1;
+	pool->generation++;
+	conditionBroadcast(&pool->wake);
+	mutexUnlock(&pool->lock);
+
+	/*The calling thread works too*/
+	runTasks(pool, 0);
+
+	mutexLock(&pool->lock);
+	while (pool->numberOfRunning > 0) conditionWait(&pool->done, &pool->lock);
+	mutexUnlock(&pool->lock);
+}
+
+int32_t threadPoolNumberOfThreads(const ThreadPool* pool)
+{
+	return pool ? pool->numberOfThreads : 1;
+}
+
+int32_t threadPoolNumberOfCores(void)
+{
+#ifdef _WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwNumberOfProcessors > 0 ? (int32_t)info.dwNumberOfProcessors : 1;
+#else
+	const long cores = sysconf(_SC_NPROCESSORS_ONLN);
+	return cores > 0 ? (int32_t)cores : 1;
+#endif
+}
@@ -0,0 +1,45 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+/*----- TYPES -----*/
+/** \brief Structure of a thread pool. Its content depends on the platform and is only known by threadpool.c*/
+typedef struct ThreadPool ThreadPool;
+
+/** \brief Function run by the thread pool for each task
+ * \param context : pointer given to threadPoolRun()
+ * \param task : index of the task, between 0 and the number of tasks - 1*/
+typedef void (*ThreadPoolTask)(void* context, const int32_t task);
+
+
+/*----- FUNCTION PROTOTYPES -----*/
+/** \brief Create a thread pool and start its worker threads
+ * \param numberOfThreads : number of threads running the tasks, including the thread calling threadPoolRun()
+ * \return pointer to the created thread pool. Return NULL if the threads can't be created*/
+ThreadPool* threadPoolCreate(const int32_t numberOfThreads);
+
+/** \brief Stop the worker threads of a thread pool and free it
+ * \param pool : thread pool to destroy. Can be NULL*/
+void threadPoolDestroy(ThreadPool* pool);
+
+/** \brief Run tasks on all the threads of the pool and wait for all of them to be done.
+ * Each thread starts with a contiguous range of tasks. A thread done with its range steals half of the remaining range of another thread
+ * \param pool : thread pool. If NULL, the tasks are run in order by the calling thread
+ * \param numberOfTasks : number of tasks to run
+ * \param task : function run for each task. It must not depend on the order in which the tasks are run
+ * \param context : pointer passed to each call of task*/
+void threadPoolRun(ThreadPool* pool, const int32_t numberOfTasks, ThreadPoolTask task, void* context);
+
+/** \brief Get the number of threads of a thread pool
+ * \param pool : thread pool. Can be NULL
+ * \return number of threads running the tasks, including the calling thread. 1 if pool is NULL*/
+int32_t threadPoolNumberOfThreads(const ThreadPool* pool);
+
+/** \brief Get the number of logical cores of the computer
+ * \return number of logical cores, at least 1*/
+int32_t threadPoolNumberOfCores(void);
+
+#endif
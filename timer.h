@@ -0,0 +1,12 @@
+#ifndef TIMER_H
+#define TIMER_H
+
+#include <stdint.h>
+
+
+/*----- FUNCTION PROTOTYPES -----*/
+/** \brief Get the time of a monotonic clock, in nanoseconds. Only the difference between two times is meaningful
+ * \return time in nanoseconds*/
+uint64_t timerNanoseconds(void);
+
+#endif
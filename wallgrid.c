@@ -0,0 +1,157 @@
+#include <stdlib.h>
+#include <string.h>
+#include "wallgrid.h"
+
+
+/*----- INTERNAL FUNCTIONS -----*/
+/** \brief Get the index of the column or row of the grid containing a coordinate. Coordinates out of the area get the border
+ * \param coordinate : x or y coordinate
+ * \param numberOfCells : number of columns or rows
+ * \return index of the column or row*/
+static int32_t cellIndex(const int coordinate, const int32_t numberOfCells)
+{
+	const int32_t i = coordinate < 0 ? 0 : coordinate / gWALL_GRID_CELL_SIZE;
+	return i < numberOfCells ? i : numberOfCells - 1;
+}
+
+/** \brief Get the first wall of a cell with an index above after
+ * \param cell : cell to search, with its walls in increasing order
+ * \param after : index of the last wall browsed
+ * \return index of the wall. -1 if there is none*/
+static int32_t firstAfter(const WallGridCell* cell, const int32_t after)
+{
+	int32_t begin = 0, end = cell->count;
+
+	/*Binary search of the first index above after*/
+	while (begin < end)
+	{
+		const int32_t middle = begin + (end - begin) / 2;
+
+		if (cell->walls[middle] <= after) begin = middle + 1;
+		else end = middle;
+	}
+	return begin < cell->count ? cell->walls[begin] : -1;
+}
+
+
+/** \brief Insert a wall in a cell, keeping the walls of the cell in increasing order
+ * \param arena : arena of the cell. NULL if it is allocated with malloc()
+ * \param cell : cell to modify
+ * \param wall : index of the wall
+ * \return false if an allocation failed*/
+static bool cellInsert(Arena* arena, WallGridCell* cell, const int32_t wall)
+{
+	int32_t i;
+
+	if (cell->count == cell->capacity)
+	{
+		const int32_t capacity = cell->capacity ? cell->capacity * 2 : 4;
+		int32_t* walls = (int32_t*)arenaGrow(arena, cell->walls, cell->capacity * sizeof(int32_t), capacity * sizeof(int32_t));
+		if (!walls) return false;
+
+		cell->walls = walls;
+		cell->capacity = capacity;
+	}
+
+	/*New walls usually have the greatest index : the loop stops at once*/
+	for (i = cell->count; i > 0 && cell->walls[i - 1] > wall; --i) cell->walls[i] = cell->walls[i - 1];
+	cell->walls[i] = wall;
+	cell->count++;
+	return true;
+}
+
+/** \brief Remove a wall from a cell, keeping the other walls in order
+ * \param cell : cell to modify
+ * \param wall : index of the wall*/
+static void cellRemove(WallGridCell* cell, const int32_t wall)
+{
+	int32_t i;
+
+	for (i = 0; i < cell->count && cell->walls[i] != wall; ++i);
+	if (i == cell->count) return;
+
+	memmove(&cell->walls[i], &cell->walls[i + 1], (cell->count - i - 1) * sizeof(int32_t));
+	cell->count--;
+}
+
+
+/*----- WALL GRID FUNCTIONS -----*/
+void wallGridInit(WallGrid* g, const int width, const int height, Arena* arena)
+{
+	g->cells = NULL;
+	g->arena = arena;
+	g->columns = width / gWALL_GRID_CELL_SIZE + 1;
+	g->rows = height / gWALL_GRID_CELL_SIZE + 1;
+}
+
+bool wallGridInsert(WallGrid* g, const int32_t wall, const int x, const int y, const int w, const int h)
+{
+	int32_t i, j;
+
+	if (!g->cells)
+	{
+		g->cells = (WallGridCell*)arenaGrow(g->arena, NULL, 0, g->columns * g->rows * sizeof(WallGridCell));
+		if (!g->cells) return false;
+		memset(g->cells, 0, g->columns * g->rows * sizeof(WallGridCell));
+	}
+
+	/*The edges of a wall are part of it, see rectHitbox()*/
+	for (j = cellIndex(y, g->rows); j <= cellIndex(y + h, g->rows); ++j)
+	{
+		for (i = cellIndex(x, g->columns); i <= cellIndex(x + w, g->columns); ++i)
+		{
+			if (!cellInsert(g->arena, &g->cells[j * g->columns + i], wall)) return false;
+		}
+	}
+	return true;
+}
+
+void wallGridRemove(WallGrid* g, const int32_t wall, const int x, const int y, const int w, const int h)
+{
+	int32_t i, j;
+
+	if (!g->cells) return;
+
+	for (j = cellIndex(y, g->rows); j <= cellIndex(y + h, g->rows); ++j)
+	{
+		for (i = cellIndex(x, g->columns); i <= cellIndex(x + w, g->columns); ++i) cellRemove(&g->cells[j * g->columns + i], wall);
+	}
+}
+
+void wallGridClear(WallGrid* g)
+{
+	int32_t i;
+
+	if (!g->cells) return;
+
+	for (i = 0; i < g->columns * g->rows; ++i) g->cells[i].count = 0;
+}
+
+int32_t wallGridNext(const WallGrid* g, const int xMin, const int yMin, const int xMax, const int yMax, const int32_t after)
+{
+	int32_t i, j, next = -1;
+
+	if (!g->cells) return -1;
+
+	for (j = cellIndex(yMin, g->rows); j <= cellIndex(yMax, g->rows); ++j)
+	{
+		for (i = cellIndex(xMin, g->columns); i <= cellIndex(xMax, g->columns); ++i)
+		{
+			const int32_t wall = firstAfter(&g->cells[j * g->columns + i], after);
+			if (wall != -1 && (next == -1 || wall < next)) next = wall;
+		}
+	}
+	return next;
+}
+
+void wallGridFree(WallGrid* g)
+{
+	int32_t i;
+
+	if (g->cells)
+	{
+		for (i = 0; i < g->columns * g->rows; ++i) arenaRelease(g->arena, g->cells[i].walls);
+	}
+	arenaRelease(g->arena, g->cells);
+	g->cells = NULL;
+}
@@ -0,0 +1,88 @@
+#ifndef WALLGRID_H
+#define WALLGRID_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "arena.h"
+
+
+/*----- CONSTANTS -----*/
+/** \brief Length of the side of a cell of the wall grid, in pixels*/
+#define gWALL_GRID_CELL_SIZE 32
+
+
+/*----- STRUCTURES -----*/
+/** \brief Structure of a cell of the wall grid
+ * \param walls : indices of the walls overlapping the cell, in increasing order
+ * \param count : number of walls overlapping the cell
+ * \param capacity : number of indices allocated in walls*/
+typedef struct WallGridCell
+{
+	int32_t* walls;
+	int32_t count;
+	int32_t capacity;
+} WallGridCell;
+
+
+/** \brief Structure of a uniform grid over the playable area, listing the walls overlapping each cell.
+ * Walls out of the area are stored in the cells of the border, so that queries out of the area still find them
+ * \param cells : cells of the grid, row by row. NULL until the first insertion
+ * \param columns : number of cells on a row
+ * \param rows : number of rows
+ * \param arena : arena of the cells. NULL if they are allocated with malloc()*/
+typedef struct WallGrid
+{
+	WallGridCell* cells;
+	int32_t columns;
+	int32_t rows;
+	Arena* arena;
+} WallGrid;
+
+
+/*----- FUNCTION PROTOTYPES -----*/
+/** \brief Initialize an empty wall grid. The cells are allocated by the first insertion
+ * \param g : wall grid to initialize
+ * \param width : width of the area covered
+ * \param height : height of the area covered
+ * \param arena : arena allocating the cells. NULL to allocate them with malloc()*/
+void wallGridInit(WallGrid* g, const int width, const int height, Arena* arena);
+
+/** \brief Add a wall to all the cells it overlaps. Inserting walls by increasing index is the fastest
+ * \param g : wall grid
+ * \param wall : index of the wall
+ * \param x : x coordinate of the upper left wedge of the wall
+ * \param y : y coordinate of the upper left wedge of the wall
+ * \param w : x length of the wall
+ * \param h : y length of the wall
+ * \return false if an allocation failed*/
+bool wallGridInsert(WallGrid* g, const int32_t wall, const int x, const int y, const int w, const int h);
+
+/** \brief Remove a wall from all the cells it overlaps
+ * \param g : wall grid
+ * \param wall : index of the wall
+ * \param x : x coordinate of the upper left wedge of the wall, as inserted
+ * \param y : y coordinate of the upper left wedge of the wall, as inserted
+ * \param w : x length of the wall, as inserted
+ * \param h : y length of the wall, as inserted*/
+void wallGridRemove(WallGrid* g, const int32_t wall, const int x, const int y, const int w, const int h);
+
+/** \brief Remove all the walls of a wall grid. The cells are kept allocated
+ * \param g : wall grid to clear*/
+void wallGridClear(WallGrid* g);
+
+/** \brief Get the wall of smallest index above after which may overlap the rectangle [xMin, xMax] x [yMin, yMax].
+ * Called with the last index returned, browse the walls near a position in increasing order, even if the position moves between two calls
+ * \param g : wall grid
+ * \param xMin : x coordinate of the left side of the rectangle
+ * \param yMin : y coordinate of the top side of the rectangle
+ * \param xMax : x coordinate of the right side of the rectangle
+ * \param yMax : y coordinate of the bottom side of the rectangle
+ * \param after : index of the last wall browsed. -1 to get the first one
+ * \return index of the wall. -1 if there is none*/
+int32_t wallGridNext(const WallGrid* g, const int xMin, const int yMin, const int xMax, const int yMax, const int32_t after);
+
+/** \brief Free the cells of a wall grid. The wall grid can be used again afterwards, with the same arena
+ * \param g : wall grid to free*/
+void wallGridFree(WallGrid* g);
+
+#endif